@@ -0,0 +1,3399 @@
+/*
+===============================================================================
+ Name        : StarFight.cpp
+ Author      : $(Giselle Chavez and Sam Musser)
+ Version     : 1.0
+ Copyright   : $(copyright)
+ Description : The main objective of this project is to create a
+ vintage dog fighter game with an overt Star Wars theme. The main
+ parts being used will include: LPC1769 for control, Nokia 5110 GLCD for
+ display, piezo for music, and custom buttons with serial interface
+ for user input.
+===============================================================================
+*/
+#if defined(BENCH) && !defined(TRACE_ENABLE)
+#define TRACE_ENABLE        //the benchmark reports over the trace
+#endif
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include "hostsim.h"
+#else
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+#include <cr_section_macros.h>
+#endif
+//**************************************************************************
+//LPC1769 definitions
+//
+
+//memory placement. the per-frame code and the interrupt handler run from
+//the 32kB local SRAM (RAM, copied there by the startup code) instead of
+//flash and its wait states, and the frame buffer sits in the AHB SRAM
+//(RAM2) away from the stack and globals the CPU is hitting. both are the
+//MCUXpresso section macros, so the managed linker scripts place them
+//without changes. FLASH_ONLY puts everything back where it was, for the
+//benchmark's "before" numbers; the host sim has no sections to use
+#if defined(HOST_SIM) || defined(FLASH_ONLY)
+#define RAMFUNC
+#define RAM2_BSS
+#else
+#define RAMFUNC __RAMFUNC(RAM)
+#define RAM2_BSS __BSS(RAM2)
+#endif
+
+//templates and inline functions can't be given a section (every object
+//that uses one gets its own copy), so the hot ones are forced inline into
+//the RAMFUNC that calls them instead
+#define RAMINLINE inline __attribute__((always_inline))
+
+//register access, the host simulator (hostsim.c) backs every address with
+//its own storage and models the parts of the buses the game reads back
+#ifdef HOST_SIM
+#define REG(addr) (*simRegister(addr))
+#define FLASH_ADDR(addr) (simFlash(addr))
+
+//keeps the bus functions from shadowing the C library's on the host
+#define read sfRead
+#define write sfWrite
+#define wait sfWait
+#else
+#define REG(addr) (*(volatile unsigned int *)(addr))
+#define FLASH_ADDR(addr) ((const void *)(addr))
+#endif
+
+// I/O definitions for some of the outputs
+#define FIO0DIR REG(0x2009c000)
+#define FIO0PIN REG(0x2009c014)
+#define FIO2DIR REG(0x2009c040)
+#define FIO2PIN REG(0x2009c054)
+
+
+//Timer Counter registers for wait function
+#define T0TCR REG(0x40004004)  //control register
+#define T0TC REG(0x40004008)   //status register
+#define T0PR REG(0x4000400c)   //prescale register
+
+//Timer 1 registers, interrupts from it toggle the piezo in the background
+#define T1IR REG(0x40008000)   //interrupt register
+#define T1TCR REG(0x40008004)  //control register
+#define T1PR REG(0x4000800c)   //prescale register
+#define T1MCR REG(0x40008014)  //match control register
+#define T1MR0 REG(0x40008018)  //match register 0
+
+//NVIC interrupt set/clear enable
+#define ISER0 REG(0xe000e100)
+#define ICER0 REG(0xe000e180)
+
+//DAC, AOUT on p0.26, for the AUDIO_DAC sound
+#define DACR REG(0x4008c000)        //value in bits 15:6
+#define DACCTRL REG(0x4008c004)     //double buffering, timeout counter, DMA
+#define DACCNTVAL REG(0x4008c008)   //PCLK_DAC ticks between DMA requests
+#define DACR_ADDR 0x4008c000
+
+//GPDMA, channel 0 feeds the DAC
+#define DMACIntTCStat REG(0x50004004)
+#define DMACIntTCClear REG(0x50004008)
+#define DMACIntErrStat REG(0x5000400c)
+#define DMACIntErrClr REG(0x50004010)
+#define DMACConfig REG(0x50004030)
+#define DMACC0SrcAddr REG(0x50004100)
+#define DMACC0DestAddr REG(0x50004104)
+#define DMACC0LLI REG(0x50004108)
+#define DMACC0Control REG(0x5000410c)
+#define DMACC0Config REG(0x50004110)
+#define DMA_IRQ 26
+
+//cycle counter for the benchmark
+#define DEMCR REG(0xe000edfc)       //debug exception and monitor control
+#define DWT_CTRL REG(0xe0001000)
+#define DWT_CYCCNT REG(0xe0001004)
+#define TIMER1_IRQ 2
+
+//I2C control definitions
+#define I2C0CONSET REG(0x4001c000)
+#define I2C0STAT REG(0x4001c004)
+#define I2C0DAT REG(0x4001c008)
+#define I2C0SCLH REG(0x4001c010)
+#define I2C0SCLL REG(0x4001c014)
+#define I2C0CONCLR REG(0x4001c018)
+
+//SPI definitions
+#define S0SPCR REG(0x40020000)  //control register
+#define S0SPSR REG(0x40020004)  //status register
+#define S0SPDR REG(0x40020008)  //data register
+#define SPTCR REG(0x40020010)   //test register
+#define S0SPCCR REG(0x4002000c) //clock counter reg
+#define S0SPINT REG(0x4002001c) //interrupt register
+
+//the pinmode definitions for the sclk and mosi
+#define PINSEL0 REG(0x4002c000)
+#define PINSEL1 REG(0x4002c004)
+#define PINSEL4 REG(0x4002c010)
+#define PINMODE1 REG(0x4002c044)
+
+//UART0 definitions for the trace output
+#define U0THR REG(0x4000c000)  //transmit holding register
+#define U0DLL REG(0x4000c000)  //divisor latch (DLAB = 1)
+#define U0DLM REG(0x4000c004)
+#define U0FCR REG(0x4000c008)  //FIFO control register
+#define U0LCR REG(0x4000c00c)  //line control register
+#define U0LSR REG(0x4000c014)  //line status register
+
+//power control to start the i2c power/control
+#define PCONP REG(0x400fc0c4)
+#define PCLKSEL0 REG(0x400fc1a8) //peripheral clock selection
+#define PCLKSEL1 REG(0x400fc1ac)
+
+//clock tree and flash accelerator
+#define FLASHCFG REG(0x400fc000)  //flash access time
+#define PLL0CON REG(0x400fc080)   //PLL0 enable/connect
+#define PLL0CFG REG(0x400fc084)   //PLL0 multiplier/divider
+#define PLL0STAT REG(0x400fc088)
+#define PLL0FEED REG(0x400fc08c)  //0xAA then 0x55 makes PLL0 changes take
+#define CCLKCFG REG(0x400fc104)   //core clock divider
+#define CLKSRCSEL REG(0x400fc10c) //PLL0 input
+#define SCS REG(0x400fc1a0)       //system controls and status (main oscillator)
+
+//**************************************************************************
+//display panel selection and geometry
+//
+//the Nokia 5110 is the default, build with DISPLAY_SSD1306 or DISPLAY_ST7565
+//defined for the 128x64 panels. objects are placed by "array position"
+//(page * GLCD_WIDTH + column) so only these constants change per panel
+
+#if defined(DISPLAY_SSD1306) || defined(DISPLAY_ST7565)
+#define GLCD_WIDTH 128     //columns
+#define GLCD_PAGES 8       //8 pixel tall rows
+#else
+#define GLCD_WIDTH 84
+#define GLCD_PAGES 6
+#endif
+
+//fastest serial clock each panel takes
+#if defined(DISPLAY_SSD1306)
+#define GLCD_SPI_HZ 10000000
+#elif defined(DISPLAY_ST7565)
+#define GLCD_SPI_HZ 20000000
+#else
+#define GLCD_SPI_HZ 4000000
+#endif
+
+#define GLCD_BYTES (GLCD_WIDTH * GLCD_PAGES)  //size of a full frame
+
+//array position of a column on a page
+#define POS(page, col) ((page) * GLCD_WIDTH + (col))
+
+//page the ships start on (middle of the screen)
+#define MID_PAGE ((GLCD_PAGES / 2) - 1)
+
+//**************************************************************************
+//clock tree
+//
+//PLL0 runs off the 12MHz crystal, FCCO = 2 * M * 12MHz / N = 400MHz with
+//M = 100 and N = 6, and the core gets FCCO / 4 = 100MHz. cclkHz and
+//pclkHz (CCLK/4, the reset default every peripheral is left on unless its
+//init says otherwise) are what every divider in here is worked out from,
+//so the numbers below are the only ones to change. if the crystal or the
+//PLL doesn't come up the core stays on the 4MHz IRC and the peripherals
+//work their dividers out for that instead
+
+#define XTAL_HZ 12000000
+#define IRC_HZ 4000000
+#define PLL_M 100
+#define PLL_N 6
+#define CCLK_DIV 4
+#define PLL_CCLK (2 * PLL_M * (XTAL_HZ / PLL_N) / CCLK_DIV)
+#define FLASH_CLOCKS ((PLL_CCLK - 1) / 20000000 + 1)  //a clock per 20MHz
+#define CLOCK_SPINS 100000        //polls before giving up on the crystal/PLL
+
+unsigned int cclkHz = IRC_HZ;     //core clock
+unsigned int pclkHz = IRC_HZ / 4; //peripheral clock (CCLK/4)
+
+//timers 0 and 1 count microseconds
+#define TIMER_PRESCALE (pclkHz / 1000000 - 1)
+
+void pllFeed()
+{
+    PLL0FEED = 0xAA;
+    PLL0FEED = 0x55;
+}
+
+//back to the IRC undivided with PLL0 disconnected and off, so cclkHz
+//(still IRC_HZ) is the clock that's really running
+void pllFallback()
+{
+    PLL0CON = 1;                  //disconnect first, if it got connected
+    pllFeed();
+    PLL0CON = 0;
+    pllFeed();
+    CCLKCFG = 0;
+    CLKSRCSEL = 0;
+}
+
+//puts the core on PLL0 following the user manual's sequence, 0 if it had
+//to stay on the IRC
+int clockInit()
+{
+    int spins;
+
+    PCLKSEL0 = 0;
+    PCLKSEL1 = 0;
+
+    //main oscillator, 1-20MHz range
+    SCS = (SCS & ~(1<<4)) | (1<<5);
+    for (spins = 0; !(SCS & (1<<6)); spins++)
+    {
+        if (spins > CLOCK_SPINS)
+        {
+            return 0;
+        }
+    }
+
+    //disconnect and disable PLL0 in case something before us started it
+    if (PLL0STAT & (1<<25))
+    {
+        PLL0CON = 1;
+        pllFeed();
+    }
+    PLL0CON = 0;
+    pllFeed();
+
+    CLKSRCSEL = 1;                //main oscillator into PLL0
+    PLL0CFG = (PLL_M - 1) | ((PLL_N - 1) << 16);
+    pllFeed();
+    PLL0CON = 1;                  //enable
+    pllFeed();
+    CCLKCFG = CCLK_DIV - 1;
+
+    for (spins = 0; !(PLL0STAT & (1<<26)); spins++)
+    {
+        if (spins > CLOCK_SPINS)
+        {
+            //no lock
+            pllFallback();
+            return 0;
+        }
+    }
+
+    //flash needs its wait states before the core speeds up
+    FLASHCFG = (FLASHCFG & 0x0FFF) | ((FLASH_CLOCKS - 1) << 12);
+    PLL0CON = 3;                  //enable and connect
+    pllFeed();
+    for (spins = 0; (PLL0STAT & (3<<24)) != (3<<24); spins++)
+    {
+        if (spins > CLOCK_SPINS)
+        {
+            //the connect didn't take, don't leave it half done
+            pllFallback();
+            return 0;
+        }
+    }
+
+    cclkHz = PLL_CCLK;
+    pclkHz = cclkHz / 4;
+    return 1;
+}
+
+//**************************************************************************
+//global constants and variable definitions
+//
+//
+
+//variables
+RAM2_BSS char output[GLCD_BYTES];  //array of the output bytes for the GLCD
+
+//the game state and rules are shared with the host tools, forced inline
+//so they're part of whichever RAM function runs them
+#define RULES_INLINE static RAMINLINE
+#include "rules.h"
+
+struct gameState game;
+
+//FNV-1a over a block of memory
+unsigned int fnvHash(const void *data, int size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+//snapshots of the whole game, for debugging and replays
+void gameSave(struct gameState *snapshot)
+{
+    *snapshot = game;
+}
+
+void gameRestore(const struct gameState *snapshot)
+{
+    game = *snapshot;
+}
+
+unsigned int gameHash(const struct gameState *state)
+{
+    return fnvHash(state, sizeof(*state));
+}
+
+//sounds
+//ticks in the alt wait function to deliver the imperial tune at desired frequencies
+int imperialTune[] = {220, 220, 220, 278, 208, 220, 278, 208, 220,
+            164, 164, 164, 155, 208, 220, 278, 208, 220};
+int pewNoise[] = {164};
+int hitNoise[] = {300};
+
+//addresses for the I/O expander
+int expWrite = 0x40;  //expander write address
+int expRead = 0x41;   //expander read address
+int DIRA = 0x00;      //Address for GPIOA
+int GPIOA = 0x12;     //write to this then read for inputs
+int GPPUA = 0x0C;     //This is to turn off pull up resistors on expander
+
+int ABRT;              //These variables are components of the status register
+int MODF;              //may not be used for final iteration
+int ROVR;
+int WCOL;
+int SPIF;
+
+//user input value for the serial controller
+volatile int inputVal = 0; 
+
+//**************************************************************************
+//art assets
+//
+//the game's sprites are ASCII art, compiled by sprites.h into page format
+//bytes, masks, mirrored and pre-shifted copies while the firmware builds,
+//so they're const data in flash with nothing to set up
+//
+//full screens live in assets.inc, built by tools/assetc.c from the images
+//in assets/. the blob starts with an index sorted by id (id, width,
+//height, format, variants, offset) and the pixels follow in page format,
+//rows of column bytes like output[]. lookups return pointers into the
+//blob (flash on the target), nothing gets copied
+
+#include "sprites.h"
+
+//tie fighter, player 2 flies the mirrored copy. it and the laser bolt (a
+//line through the middle of its page) are drawn in rules.h, the tools draw
+//their screens from the same art
+constexpr auto tieSprite = spriteCompile<TIE_WIDTH, 8>(TIE_ART);
+constexpr auto laserSprite = spriteCompile<LASER_WIDTH, 8>(LASER_ART);
+
+//ball, in case there is the desire to implement pong later
+constexpr auto ballSprite = spriteCompile<2, 8>(
+    ".."
+    ".."
+    ".."
+    "##"
+    "##"
+    ".."
+    ".."
+    "..");
+
+#include "assets.inc"
+
+#define ASSET_FORMAT_PAGES 1
+
+struct assetInfo
+{
+    int width;
+    int height;
+    int pages;          //rows of bytes in one variant
+    int variants;       //1, or 8 for pre-shifted images
+    const char *data;   //variant 0
+};
+
+const unsigned char *assets = assetBlob;
+
+//finds an asset by id with a binary search of the index, 0 if it's found
+int assetFind(int id, struct assetInfo *info)
+{
+    int lo = 0;
+    int hi = assets[4] | (assets[5] << 8);
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        const unsigned char *entry = assets + 8 + 12 * mid;
+        int entryId = entry[0] | (entry[1] << 8);
+
+        if (entryId < id)
+        {
+            lo = mid + 1;
+        }
+        else if (entryId > id)
+        {
+            hi = mid;
+        }
+        else
+        {
+            info->width = entry[2];
+            info->height = entry[3];
+            info->variants = entry[5];
+            info->pages = (info->variants == 1) ? (info->height + 7) / 8 :
+                          (info->height + 14) / 8;
+            info->data = (const char *)(assets + (entry[8] | (entry[9] << 8) |
+                                        (entry[10] << 16) | (entry[11] << 24)));
+            return (entry[4] == ASSET_FORMAT_PAGES) ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+struct assetInfo titleArt;
+
+void assetsInit()
+{
+#ifdef HOST_SIM
+    assets = simAssets(assetBlob);
+#endif
+    assetFind(ASSET_TITLE, &titleArt);
+}
+
+//**************************************************************************
+//standard initialization methods per LPC1769 and Nokia 5110 data sheets
+//and the serial interface functions for the user input
+//
+
+#define I2C_HZ 400000             //fast mode, the MCP23017 takes up to 1.7MHz
+
+//LPC I2C subsystem initialization
+void I2C_init()
+{
+    //starts the I2C0 interface power/clock control
+    PCONP |= (1<<7);
+
+    //Need to turn off pull up or down resistors for p0.27/28
+    PINMODE1 |= (1<<22) | (1<<24);
+
+    //have to set p0.28/27 to SDA and SCL modes w/ 01
+    //for bits 23/22 and 25/24
+    PINSEL1 &= ~(1<<23); //p0.27
+    PINSEL1 |= (1<<22);
+    PINSEL1 &= ~(1<<25); //p0.28
+    PINSEL1 |= (1<<24);
+
+    //SCL = PCLK / (SCLH + SCLL), with the low half longer than the high
+    //since fast mode wants 1.3us low and 0.6us high
+    int scl = (pclkHz + I2C_HZ - 1) / I2C_HZ;
+    int high = (scl / 3 < 4) ? 4 : scl / 3;
+    I2C0SCLL = (scl - high < 4) ? 4 : scl - high;  //low div
+    I2C0SCLH = high;                               //high div
+
+    I2C0CONSET = (1<<6); //enable I2C
+}
+
+//LPC SPI subsystem initialization
+void SPI_init()
+{
+    //Activates MOSI and SCLK modes by going high
+    //at the following bits
+    PINSEL0 |= (1<<31) | (1<<30);   //SCLK (clock, p0.15)
+    PINSEL1 |= (1<<5) | (1<<4);     //MOSI (data out, p0.18)
+
+    //setting the output pins (arbitrary, but we chose these)
+    FIO0DIR |= (1<<9);   //GLCD SCE   output
+    FIO0DIR |= (1<<8);   //GLCD RESET output
+    FIO0DIR |= (1<<7);   //GLCD D/C   output (1/0)
+
+    //initialize SPI subsystem in lpc
+    S0SPCR &= ~(1<<2); //bit enabler
+    S0SPCR &= ~(1<<3); //cphase as 0
+    S0SPCR &= ~(1<<4); // cpolarity as 0 (sck active high)
+    S0SPCR |= (1<<5);  //selects master mode (only one we need)
+    S0SPCR &= ~(1<<6); //chooses least sig bit first if high
+    S0SPCR &= ~(1<<7); //does not use interrupts
+
+    //SPI runs off CCLK for a finer divider, SCK = CCLK / S0SPCCR which
+    //has to be even and at least 8, as fast as the panel allows
+    PCLKSEL0 = (PCLKSEL0 & ~(3<<16)) | (1<<16);
+    int div = (cclkHz + GLCD_SPI_HZ - 1) / GLCD_SPI_HZ;
+    div = (div + 1) & ~1;
+    S0SPCCR = (div < 8) ? 8 : div;
+}
+
+//**************************************************************************
+//bus deadlines and error counters
+//
+//every wait on the SPI or I2C hardware gives up after a deadline on
+//timer 0 instead of spinning forever, and every I2C step checks I2C0STAT
+//for the state it should have left the bus in, so a NACK or a lost
+//arbitration fails the transaction too. a failed I2C transaction skips the
+//rest of its bytes, the bus is recovered and the game carries on with the
+//last good controller sample; the expander is then polled with a growing
+//backoff so a missing controller can't eat the frame. worst case with
+//everything unplugged is one SPI timeout per flush plus, per checkIn(),
+//four I2C timeouts and a recovery (about 9ms) once per backoff period
+
+#define SPI_TIMEOUT 500           //us per byte, a byte normally takes 2us
+#define I2C_TIMEOUT 2000          //us per step, a byte normally takes 25us
+#define I2C_MAX_BACKOFF 64        //polls skipped after repeated failures
+
+struct busErrors
+{
+    unsigned int spiTimeouts;
+    unsigned int i2cTimeouts;
+    unsigned int i2cNacks;        //any unexpected I2C0STAT, NACKs mostly
+    unsigned int i2cRecoveries;
+    unsigned int degradedPolls;   //checkIn()s answered from the last sample
+};
+
+struct busErrors busErr;
+
+//traffic counters, turned into a utilization summary once a second by
+//busReport(). busy time is worked out there from the byte counts and bus
+//clocks; wait time is timer 0 spent in the polling loops (the host sim's
+//bus models supply it instead). idle bytes are display data the panel
+//already had, going by panelShadow, so they're what skipping unchanged
+//columns would save
+struct busStats
+{
+    unsigned int spiBytes;        //command and data
+    unsigned int spiIdle;         //data bytes that didn't change anything
+    unsigned int spiTransfers;    //command lists and data windows
+    unsigned int spiWaitUs;
+    unsigned int i2cBytes;        //address and data, both directions
+    unsigned int i2cTransfers;    //start to stop
+    unsigned int i2cWaitUs;
+};
+
+struct busStats busStat;
+RAM2_BSS unsigned char panelShadow[GLCD_BYTES];   //what the panel's RAM holds
+
+int spiFault = 0;                 //set by a timeout, cleared per flush
+int i2cFault = 0;                 //set by a timeout or bad status, cleared per transaction
+int i2cHoldoff = 0;               //polls left to skip
+int i2cBackoff = 1;               //holdoff to use after the next failure
+int expanderReady = 0;            //expander's inputs have been set up
+
+//spins for a few microseconds, used to bit-bang the bus recovery
+void busDelay(int us)
+{
+    unsigned int t0 = T0TC;
+
+    while ((T0TC - t0) < (unsigned int)us) {}
+}
+
+//**************************************************************************
+//display drivers
+//
+//every panel sits on the same SPI pins (SCE p0.9, RESET p0.8, D/C p0.7)
+//and gets a driver with the same three operations. flush sends a
+//width x pages block of buf (rows of width bytes) to that window using
+//whatever addressing mode moves it with the least command overhead. only
+//the SSD1306 can bound a window in hardware, the others are given a start
+//address for each row that doesn't run on from the last one
+
+struct displayDriver
+{
+    void (*init)(void);                  //reset, configure, end in data mode
+    void (*flush)(const char *buf, int col, int page, int width, int pages);
+    void (*contrast)(int level);
+};
+
+//sends one byte and makes sure it passes through before moving on
+//(once a byte has timed out the rest of the flush is skipped)
+RAMFUNC void spiSend(char data)
+{
+    if (spiFault)
+    {
+        return;
+    }
+    busStat.spiBytes++;
+#ifdef HOST_SIM
+    simSpiSend(data);
+#else
+    unsigned int t0 = T0TC;
+
+    S0SPDR = data;
+    while (((S0SPSR >> 7)&1) == 0)
+    {
+        if ((T0TC - t0) > SPI_TIMEOUT)
+        {
+            busErr.spiTimeouts++;
+            spiFault = 1;
+            break;
+        }
+    }
+    busStat.spiWaitUs += T0TC - t0;
+#endif
+}
+
+//counts a data window's bytes that match what the panel is already
+//showing and records the new ones, for the drivers' flushes
+RAMFUNC void spiShadow(const char *buf, int col, int page, int width, int pages)
+{
+    busStat.spiTransfers++;
+    for (int p = 0; p < pages; p++)
+    {
+        unsigned char *shadow = &panelShadow[POS(page + p, col)];
+        const unsigned char *row = (const unsigned char *)&buf[p * width];
+
+        for (int i = 0; i < width; i++)
+        {
+            if (shadow[i] == row[i])
+            {
+                busStat.spiIdle++;
+            }
+            shadow[i] = row[i];
+        }
+    }
+}
+
+//sends a list of command bytes then goes back to data mode
+void glcdCommands(const unsigned char *cmds, int count)
+{
+    FIO0PIN &= ~(1<<7);  //D/C low for command mode
+    busStat.spiTransfers++;
+
+    for (int i = 0; i < count; i++)
+    {
+        spiSend(cmds[i]);
+    }
+
+    FIO0PIN |= (1<<7);   //data mode for the glcd
+}
+
+//pulses reset and selects the panel (shared by all the drivers)
+void glcdReset()
+{
+    FIO0PIN |= (1<<8);
+    FIO0PIN &= ~(1<<8);
+    FIO0PIN |= (1<<8);   //clears the GLCD from previous use
+
+    FIO0PIN |= (1<<9);   //chip select (active low)
+    FIO0PIN &= ~(1<<9);  //falling edge begins the process
+}
+
+//Nokia 5110 (PCD8544) initialization that ends in data mode (ready to write)
+void nokiaInit()
+{
+    const unsigned char cmds[] = {
+        0b00100001, //per instructions on GLCD data sheet
+        0b11001000, //sets Vop to 16 x b[V] (per dataSheet) (contrast)
+        0b00100000, //function set PD = 0 and V = 0 (normal instruction)
+        0b00000100, //sets the temperature coefficient
+        0b00010100, //makes the glcd bias mode 1:48
+        0b00001100  //display control set normal mode (D=1, E=1)
+    };
+
+    glcdReset();
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+//the 5110 only has a start address (X and bank), it wraps to the next
+//bank at the end of each row
+void nokiaAddress(int col, int page)
+{
+    const unsigned char cmds[] = {(unsigned char)(0x80 | col), (unsigned char)(0x40 | page)};
+
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+RAMFUNC void nokiaFlush(const char *buf, int col, int page, int width, int pages)
+{
+    spiShadow(buf, col, page, width, pages);
+
+    //full width windows wrap on their own so one address set covers it
+    if (width == GLCD_WIDTH)
+    {
+        nokiaAddress(col, page);
+        for (int i = 0; i < width * pages; i++)
+        {
+            spiSend(buf[i]);
+        }
+        return;
+    }
+
+    for (int p = 0; p < pages; p++)
+    {
+        nokiaAddress(col, page + p);
+        for (int i = 0; i < width; i++)
+        {
+            spiSend(buf[p * width + i]);
+        }
+    }
+}
+
+//level is Vop, 0-127
+void nokiaContrast(int level)
+{
+    const unsigned char cmds[] = {0b00100001, (unsigned char)(0x80 | (level & 0x7F)), 0b00100000};
+
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+//SSD1306 128x64 OLED, 4-wire SPI
+void ssd1306Init()
+{
+    const unsigned char cmds[] = {
+        0xAE,       //display off while configuring
+        0xD5, 0x80, //clock divide ratio/oscillator
+        0xA8, 0x3F, //multiplex ratio 1:64
+        0xD3, 0x00, //no display offset
+        0x40,       //start line 0
+        0x8D, 0x14, //internal charge pump on
+        0x20, 0x00, //horizontal addressing so windows fill in one burst
+        0xA1,       //column 127 mapped to SEG0
+        0xC8,       //scan COM from the bottom
+        0xDA, 0x12, //alternative COM pin config
+        0x81, 0xCF, //contrast
+        0xD9, 0xF1, //precharge period
+        0xDB, 0x40, //VCOMH deselect level
+        0xA4,       //display follows RAM
+        0xA6,       //not inverted
+        0xAF        //display on
+    };
+
+    glcdReset();
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+//the SSD1306 clips its address pointer to the window in hardware
+void ssd1306SetWindow(int col, int page, int width, int pages)
+{
+    const unsigned char cmds[] = {
+        0x21, (unsigned char)col, (unsigned char)(col + width - 1),
+        0x22, (unsigned char)page, (unsigned char)(page + pages - 1)
+    };
+
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+RAMFUNC void ssd1306Flush(const char *buf, int col, int page, int width, int pages)
+{
+    spiShadow(buf, col, page, width, pages);
+    ssd1306SetWindow(col, page, width, pages);
+    for (int i = 0; i < width * pages; i++)
+    {
+        spiSend(buf[i]);
+    }
+}
+
+//level is 0-255
+void ssd1306Contrast(int level)
+{
+    const unsigned char cmds[] = {0x81, (unsigned char)level};
+
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+//ST7565 128x64 LCD
+void st7565Init()
+{
+    const unsigned char cmds[] = {
+        0xA2,       //bias 1/9
+        0xA0,       //normal column direction
+        0xC8,       //reverse COM scan
+        0x2F,       //booster, regulator and follower on
+        0x27,       //regulator resistor ratio
+        0x81, 0x18, //electronic volume (contrast)
+        0x40,       //start line 0
+        0xAF        //display on
+    };
+
+    glcdReset();
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+//the ST7565 only has page addressing and no column end, so a window is
+//addressed a row at a time
+void st7565Address(int col, int page)
+{
+    const unsigned char cmds[] = {(unsigned char)(0xB0 | page), (unsigned char)(0x10 | (col >> 4)),
+                                  (unsigned char)(col & 0x0F)};
+
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+RAMFUNC void st7565Flush(const char *buf, int col, int page, int width, int pages)
+{
+    spiShadow(buf, col, page, width, pages);
+    for (int p = 0; p < pages; p++)
+    {
+        st7565Address(col, page + p);
+        for (int i = 0; i < width; i++)
+        {
+            spiSend(buf[p * width + i]);
+        }
+    }
+}
+
+//level is 0-63
+void st7565Contrast(int level)
+{
+    const unsigned char cmds[] = {0x81, (unsigned char)(level & 0x3F)};
+
+    glcdCommands(cmds, sizeof(cmds));
+}
+
+#if defined(DISPLAY_SSD1306)
+const struct displayDriver display = {ssd1306Init, ssd1306Flush, ssd1306Contrast};
+#elif defined(DISPLAY_ST7565)
+const struct displayDriver display = {st7565Init, st7565Flush, st7565Contrast};
+#else
+const struct displayDriver display = {nokiaInit, nokiaFlush, nokiaContrast};
+#endif
+
+//GLCD initialization for whichever panel was built in, ready for writing
+void GLCD_init()
+{
+    spiFault = 0;
+    display.init();
+}
+
+//Serial Functions:
+//each step waits on the hardware with a deadline and checks the status it
+//ends in, once one has failed (i2cFault) the rest of the transaction does
+//nothing
+
+//I2C0STAT master states
+#define I2C_STARTED 0x08          //start sent
+#define I2C_RESTARTED 0x10        //repeated start sent
+#define I2C_ADDR_W_ACK 0x18       //SLA+W sent, ACK back
+#define I2C_DATA_W_ACK 0x28       //data sent, ACK back
+#define I2C_ADDR_R_ACK 0x40       //SLA+R sent, ACK back
+#define I2C_DATA_R_ACK 0x50       //data in, ACK sent
+#define I2C_DATA_R_NACK 0x58      //data in, NACK sent (the last byte)
+
+//waits for the mask bits of I2C0CONSET to read as want, flags the
+//transaction as failed if they don't in time
+void i2cWaitFor(unsigned int mask, unsigned int want)
+{
+    unsigned int t0 = T0TC;
+
+    while ((I2C0CONSET & mask) != want)
+    {
+        if ((T0TC - t0) > I2C_TIMEOUT)
+        {
+            busErr.i2cTimeouts++;
+            i2cFault = 1;
+            break;
+        }
+    }
+    busStat.i2cWaitUs += T0TC - t0;
+}
+
+#ifndef HOST_SIM
+//after a step's wait, fails the transaction unless I2C0STAT is one of the
+//states the step can end in. anything else is a NACK, a lost arbitration
+//or a bus error, so it sends a stop to let go of the bus (the one stop()
+//would have sent) and i2cRecover() sorts the rest out
+void i2cExpect(unsigned int a, unsigned int b, unsigned int c)
+{
+    unsigned int stat;
+
+    if (i2cFault)
+    {
+        return;
+    }
+    stat = I2C0STAT & 0xF8;
+    if ((stat != a) && (stat != b) && (stat != c))
+    {
+        busErr.i2cNacks++;
+        i2cFault = 1;
+        I2C0CONSET = (1<<4);    //sets the sto
+        I2C0CONCLR = (1<<3);
+    }
+}
+#endif
+
+//start function for beginning a read/write process
+void start(void)
+{
+    if (i2cFault)
+    {
+        return;
+    }
+    busStat.i2cTransfers++;
+#ifdef HOST_SIM
+    simI2cStart();
+#else
+    I2C0CONSET = (1<<3);    //set SI
+    I2C0CONSET = (1<<5);    //set STA
+    I2C0CONCLR = (1<<3);    //clear SI
+    //makes sure there is completion before moving on
+    i2cWaitFor(1<<3, 1<<3);
+    I2C0CONCLR = (1<<5);    //clear STA
+    i2cExpect(I2C_STARTED, I2C_RESTARTED, I2C_RESTARTED);
+#endif
+}
+
+//read function for reading in data to the i2c
+int read(int heard)
+{
+    if (i2cFault)
+    {
+        return 0;
+    }
+    busStat.i2cBytes++;
+#ifdef HOST_SIM
+    return simI2cRead(heard);
+#else
+    if(heard) 
+    {
+        I2C0CONSET = (1<<2); //accepts data
+    } 
+    else 
+    {
+        I2C0CONCLR = (1<<2);
+    }
+    I2C0CONCLR = (1<<3);
+    //waits for complete
+    i2cWaitFor(1<<3, 1<<3);
+    i2cExpect(I2C_DATA_R_ACK, I2C_DATA_R_NACK, I2C_DATA_R_NACK);
+    return i2cFault ? 0 : (I2C0DAT & 0xFF);
+#endif
+}
+
+//write function for i2c to output bit values
+void write(int num)
+{
+    if (i2cFault)
+    {
+        return;
+    }
+    busStat.i2cBytes++;
+#ifdef HOST_SIM
+    simI2cWrite(num);
+#else
+    I2C0DAT = num;      //takes in the information
+    I2C0CONCLR = (1<<3);
+    //waits for completion
+    i2cWaitFor(1<<3, 1<<3);
+    //an address (either direction) or data, all acknowledged
+    i2cExpect(I2C_ADDR_W_ACK, I2C_DATA_W_ACK, I2C_ADDR_R_ACK);
+#endif
+}
+
+//stop function for ending the read/write process
+void stop(void)
+{
+    if (i2cFault)
+    {
+        return;
+    }
+#ifdef HOST_SIM
+    simI2cStop();
+#else
+    I2C0CONSET = (1<<4);    //sets the sto
+    I2C0CONCLR = (1<<3);
+    //same idea as in the start function
+    i2cWaitFor(1<<4, 0);
+#endif
+}
+
+//frees a slave that is holding SDA low (usually one that lost a clock
+//mid-byte when the cable was knocked) by clocking SCL by hand until it
+//lets go, then sending a stop and handing the pins back to I2C0.
+//p0.27 (SDA) and p0.28 (SCL) are open drain, so driving them high as
+//outputs only releases the line
+void i2cRecover()
+{
+#ifndef HOST_SIM
+    I2C0CONCLR = (1<<6) | (1<<5) | (1<<3) | (1<<2); //I2C off, STA/SI/AA clear
+
+    PINSEL1 &= ~((3<<22) | (3<<24));  //both pins back to GPIO
+    FIO0PIN |= (1<<27) | (1<<28);
+    FIO0DIR |= (1<<27) | (1<<28);
+
+    //nine clocks gets any slave through the rest of its byte and the ack
+    for (int c = 0; c < 9; c++)
+    {
+        FIO0PIN &= ~(1<<28);
+        busDelay(5);
+        FIO0PIN |= (1<<28);
+        busDelay(5);
+    }
+
+    //stop condition, SDA rising while SCL is high
+    FIO0PIN &= ~(1<<27);
+    busDelay(5);
+    FIO0PIN |= (1<<27);
+    busDelay(5);
+
+    FIO0DIR &= ~((1<<27) | (1<<28));
+    PINSEL1 |= (1<<22) | (1<<24);     //SDA and SCL again
+    I2C0CONSET = (1<<6);              //enable I2C
+#endif
+    busErr.i2cRecoveries++;
+    expanderReady = 0;                //its setup may not have survived
+}
+
+//**************************************************************************
+//persistent scores and settings
+//
+//an append-only log of 16 byte records kept in the last two 32kB flash
+//sectors (28 and 29, the linker's flash region has to stop short of them).
+//new values are batched in RAM and programmed a whole 256 byte page at a
+//time by logCommit(), which only runs once the game-over screen has been
+//up for GAME_OVER_US, after the last frame and the hit sound are done.
+//when the active sector fills, the live values are copied into the other
+//one and its header is written last, so a power cut at any point leaves
+//one complete copy. alternating sectors spreads the erases across both
+
+#define IAP_LOCATION 0x1FFF1FF1
+
+#define LOG_SECTOR 28             //first of the two sectors
+#define LOG_BASE 0x00070000       //its address
+#define LOG_SECTOR_SIZE 0x8000
+#define LOG_PAGE_SIZE 256         //smallest IAP write
+#define LOG_PER_PAGE 16           //records per page
+#define LOG_PAGES (LOG_SECTOR_SIZE / LOG_PAGE_SIZE)
+
+#define LOG_HEADER 0xFE           //key of a sector's header record
+#define LOG_EMPTY 0xFFFFFFFF      //an erased word
+
+//record keys
+#define KEY_HISCORE 0             //longest single player run (frames)
+#define KEY_P1WINS 1              //multiplayer win tallies
+#define KEY_P2WINS 2
+#define KEY_DIFFICULTY 3
+#define KEY_VOLUME 4
+#define KEY_ENDURANCE 5           //longest endurance run (frames)
+#define LOG_KEYS 6
+
+struct logRecord
+{
+    unsigned int key;
+    unsigned int seq;             //newest record for a key wins
+    int value;                    //(generation for a header)
+    unsigned int check;           //hash of the above, catches torn writes
+};
+
+//RAM index built by the boot scan, starts out holding the defaults
+int logValue[LOG_KEYS] = {0, 0, 0, 1, 3, 0};
+unsigned int logSeq = 0;          //sequence number of the newest record
+int logSector = -1;               //sector being appended to (0/1, -1 none)
+int logNextPage = 0;              //next unwritten page in it
+int logGen = 0;                   //generation of that sector
+
+//page being batched up for the next commit
+struct logRecord logPage[LOG_PER_PAGE];
+int logPending = 0;
+
+//FNV-1a over the first three words
+unsigned int logHash(const struct logRecord *rec)
+{
+    return fnvHash(rec, 12);
+}
+
+//first record of a page in one of the two log sectors
+const struct logRecord *logRecords(int sector, int page)
+{
+    return (const struct logRecord *)FLASH_ADDR(LOG_BASE +
+            sector * LOG_SECTOR_SIZE + page * LOG_PAGE_SIZE);
+}
+
+#ifndef HOST_SIM
+//calls into the boot ROM, interrupts stay off while the flash is busy
+unsigned int iap(unsigned int cmd, unsigned int p0, unsigned int p1,
+                 unsigned int p2, unsigned int p3)
+{
+    unsigned int command[5] = {cmd, p0, p1, p2, p3};
+    unsigned int result[5];
+
+    __asm volatile ("cpsid i");
+    ((void (*)(unsigned int *, unsigned int *))IAP_LOCATION)(command, result);
+    __asm volatile ("cpsie i");
+
+    return result[0];
+}
+#endif
+
+//erases one of the log sectors, 0 on success
+int flashErase(int sector)
+{
+#ifdef HOST_SIM
+    return simFlashErase(LOG_SECTOR + sector);
+#else
+    iap(50, LOG_SECTOR + sector, LOG_SECTOR + sector, 0, 0);  //prepare
+    return iap(52, LOG_SECTOR + sector, LOG_SECTOR + sector, cclkHz / 1000, 0);
+#endif
+}
+
+//programs one page of a log sector from a word aligned RAM buffer
+int flashProgram(int sector, int page, const struct logRecord *src)
+{
+    unsigned int addr = LOG_BASE + sector * LOG_SECTOR_SIZE + page * LOG_PAGE_SIZE;
+
+#ifdef HOST_SIM
+    return simFlashProgram(addr, src, LOG_PAGE_SIZE);
+#else
+    iap(50, LOG_SECTOR + sector, LOG_SECTOR + sector, 0, 0);  //prepare
+    return iap(51, addr, (unsigned int)src, LOG_PAGE_SIZE, cclkHz / 1000);
+#endif
+}
+
+//the sector's header, or 0 if it was never finished
+const struct logRecord *logHeader(int sector)
+{
+    const struct logRecord *hdr = logRecords(sector, 0);
+
+    if ((hdr->key != LOG_HEADER) || (hdr->check != logHash(hdr)))
+    {
+        return 0;
+    }
+    return hdr;
+}
+
+//builds the RAM index with one pass over the newest sector, stopping at
+//the first page that was never programmed
+void logInit()
+{
+    const struct logRecord *hdr0 = logHeader(0);
+    const struct logRecord *hdr1 = logHeader(1);
+    unsigned int newest[LOG_KEYS] = {0};
+
+    if (hdr0 && (!hdr1 || (hdr0->value > hdr1->value)))
+    {
+        logSector = 0;
+        logGen = hdr0->value;
+    }
+    else if (hdr1)
+    {
+        logSector = 1;
+        logGen = hdr1->value;
+    }
+    else
+    {
+        return;  //never written, the first commit formats a sector
+    }
+
+    logSeq = logRecords(logSector, 0)->seq;
+
+    for (logNextPage = 1; logNextPage < LOG_PAGES; logNextPage++)
+    {
+        const struct logRecord *rec = logRecords(logSector, logNextPage);
+        const unsigned int *words = (const unsigned int *)rec;
+        int used = 0;
+
+        for (int w = 0; w < LOG_PAGE_SIZE / 4; w++)
+        {
+            if (words[w] != LOG_EMPTY)
+            {
+                used = 1;
+                break;
+            }
+        }
+        if (!used)
+        {
+            break;
+        }
+
+        for (int r = 0; r < LOG_PER_PAGE; r++)
+        {
+            if ((rec[r].key < LOG_KEYS) && (rec[r].check == logHash(&rec[r])) &&
+                    (rec[r].seq > newest[rec[r].key]))
+            {
+                newest[rec[r].key] = rec[r].seq;
+                logValue[rec[r].key] = rec[r].value;
+            }
+            if ((rec[r].check == logHash(&rec[r])) && (rec[r].seq > logSeq))
+            {
+                logSeq = rec[r].seq;
+            }
+        }
+    }
+}
+
+//fills the unused end of the page buffer with erased words and seals
+//each record with its hash
+void logSeal(int count)
+{
+    for (int r = 0; r < LOG_PER_PAGE; r++)
+    {
+        if (r < count)
+        {
+            logPage[r].check = logHash(&logPage[r]);
+        }
+        else
+        {
+            logPage[r].key = LOG_EMPTY;
+            logPage[r].seq = LOG_EMPTY;
+            logPage[r].value = (int)LOG_EMPTY;
+            logPage[r].check = LOG_EMPTY;
+        }
+    }
+}
+
+//copies every live value into the other sector and makes it the active one
+void logCompact()
+{
+    int next = (logSector == 0) ? 1 : 0;
+
+    flashErase(next);
+
+    for (int k = 0; k < LOG_KEYS; k++)
+    {
+        logPage[k].key = k;
+        logPage[k].seq = ++logSeq;
+        logPage[k].value = logValue[k];
+    }
+    logSeal(LOG_KEYS);
+    flashProgram(next, 1, logPage);
+
+    //header last, the sector doesn't count until it's there
+    logPage[0].key = LOG_HEADER;
+    logPage[0].seq = logSeq;
+    logPage[0].value = ++logGen;
+    logSeal(1);
+    flashProgram(next, 0, logPage);
+
+    logSector = next;
+    logNextPage = 2;
+    logPending = 0;
+}
+
+//records a new value in the RAM index and queues it for the next commit,
+//repeated writes of one key before a commit share a slot
+void logPut(int key, int value)
+{
+    int r;
+
+    if (logValue[key] == value)
+    {
+        return;
+    }
+    logValue[key] = value;
+
+    for (r = 0; r < logPending; r++)
+    {
+        if (logPage[r].key == (unsigned int)key)
+        {
+            break;
+        }
+    }
+    if (r == logPending)
+    {
+        logPending++;
+    }
+
+    logPage[r].key = key;
+    logPage[r].seq = ++logSeq;
+    logPage[r].value = value;
+}
+
+//programs whatever has been queued, only call this while the game can
+//afford to stall (a page takes around a millisecond, a compaction longer)
+void logCommit()
+{
+    if (logPending == 0)
+    {
+        return;
+    }
+
+    if ((logSector < 0) || (logNextPage >= LOG_PAGES))
+    {
+        logCompact();
+        return;
+    }
+
+    logSeal(logPending);
+    flashProgram(logSector, logNextPage, logPage);
+    logNextPage++;
+    logPending = 0;
+}
+
+//**************************************************************************
+//event trace
+//
+//TRACE() drops a fixed size record (timer 0 tick, event id, two args) into
+//a RAM ring, which traceDrain() trickles out of UART0 (TXD0, p0.2) a
+//FIFO's worth at a time whenever the game has a spare moment. records
+//that don't fit are counted and dropped rather than waited on. built
+//without TRACE_ENABLE the calls compile to nothing
+//
+//on the wire each record is a 0xA5 sync byte and the record, little
+//endian. tools/tracedump.c turns a capture back into a timeline
+
+#define TRACE_SIZE 64             //records, a power of two
+#define TRACE_SYNC 0xA5
+#define TRACE_BAUD 115200         //a frame's TR_FRAME and TR_TASKs are 54 bytes on
+                                  //the wire, about 12% of the link at 25 frames a second
+
+//event ids (a, b)
+#define TR_INPUT 1                //controller edge (new bits, old bits)
+#define TR_FIRE 2                 //player laser (fireLaser() case, position)
+#define TR_WAVE 3                 //single player wave (player's page, lane mask)
+#define TR_HIT 4                  //ship hit (player hit, laser position)
+#define TR_GAMEOVER 5             //game over (1 single/2 multi/3 endurance, score or winner)
+#define TR_FRAME 6                //frame start (0, frame number)
+#define TR_OVERRUN 7              //frame over budget (0, frame length in 100us)
+#define TR_BOOT 8                 //boot stage reached (stage, GLCD_WIDTH for decoding positions)
+#define TR_BUSFAULT 9             //bus fault (1 I2C/2 SPI, faults so far)
+#define TR_TASK 10                //task run time in a frame (task, us)
+#define TR_BENCH 11               //benchmark figure (section/stat, cycles / 16)
+#define TR_BUS 12                 //bus utilization over the last second (BUS_ figure, value)
+
+#define FRAME_BUDGET 40000        //us, about what the SPI flush leaves room for
+
+struct traceRecord
+{
+    unsigned int tick;
+    unsigned char id;
+    unsigned char a;
+    unsigned short b;
+};
+
+RAM2_BSS struct traceRecord traceRing[TRACE_SIZE];
+volatile unsigned int traceHead = 0;   //next record to fill
+unsigned int traceTail = 0;            //record being sent
+int traceByte = -1;                    //byte of it next (-1 is the sync)
+unsigned int traceDropped = 0;
+
+#ifdef TRACE_ENABLE
+#define TRACE(id, a, b) traceEvent((id), (a), (b))
+#else
+#define TRACE(id, a, b) ((void)0)
+#endif
+
+RAMFUNC void traceEvent(int id, int a, int b)
+{
+    unsigned int head = traceHead;
+    struct traceRecord *rec;
+
+    if (head - traceTail >= TRACE_SIZE)
+    {
+        traceDropped++;
+        return;
+    }
+
+    rec = &traceRing[head & (TRACE_SIZE - 1)];
+    rec->tick = T0TC;
+    rec->id = id;
+    rec->a = a;
+    rec->b = b;
+    traceHead = head + 1;
+}
+
+//8 data bits, no parity, 1 stop bit with UART0 running off the core clock
+void traceInit()
+{
+    unsigned int div = (cclkHz + 8 * TRACE_BAUD) / (16 * TRACE_BAUD);
+
+    PCONP |= (1<<3);
+    PCLKSEL0 = (PCLKSEL0 & ~(3<<6)) | (1<<6);  //PCLK_UART0 = CCLK
+    PINSEL0 = (PINSEL0 & ~(3<<4)) | (1<<4);    //p0.2 as TXD0
+
+    U0LCR = (1<<7) | 3;                        //DLAB to set the divisor
+    U0DLL = div & 0xFF;                        //54 at 100MHz, 326 for 19200
+    U0DLM = div >> 8;
+    U0LCR = 3;
+    U0FCR = (1<<0) | (1<<2);                   //FIFO on, TX FIFO reset
+}
+
+//tops the transmit FIFO up from the ring, never waits
+void traceDrain()
+{
+#ifdef TRACE_ENABLE
+    int room;
+
+    //THRE means the 16 byte FIFO is completely empty
+    if (!(U0LSR & (1<<5)))
+    {
+        return;
+    }
+
+    for (room = 16; (room > 0) && (traceTail != traceHead); room--)
+    {
+        const unsigned char *rec =
+            (const unsigned char *)&traceRing[traceTail & (TRACE_SIZE - 1)];
+        unsigned char data = (traceByte < 0) ? TRACE_SYNC : rec[traceByte];
+
+#ifdef HOST_SIM
+        simUartSend(data);
+#else
+        U0THR = data;
+#endif
+        if (++traceByte == sizeof(struct traceRecord))
+        {
+            traceByte = -1;
+            traceTail++;
+        }
+    }
+#endif
+}
+
+//frame markers around each pass of a game loop
+unsigned int frameStart = 0;
+unsigned int frameCount = 0;
+
+void frameBegin()
+{
+    frameStart = T0TC;
+    frameCount++;
+    TRACE(TR_FRAME, 0, frameCount);
+}
+
+void frameEnd()
+{
+    unsigned int length = T0TC - frameStart;
+
+    if (length > FRAME_BUDGET)
+    {
+        TRACE(TR_OVERRUN, 0, (length / 100 > 0xFFFF) ? 0xFFFF : length / 100);
+    }
+    traceDrain();
+}
+
+//bus utilization, a TR_BUS record per figure every BUS_REPORT_US with the
+//counts for that second (tools/tracedump.c divides by the frames for the
+//per frame figures). busy is the share of the second the bus was clocking,
+//start and stop counted as a bit each on I2C, and wait the share of the
+//CPU's time spent polling for it
+#define BUS_REPORT_US 1000000
+#define BUS_FRAMES 0              //frames started
+#define BUS_SPI_BYTES 1
+#define BUS_SPI_IDLE 2
+#define BUS_SPI_TRANSFERS 3
+#define BUS_SPI_BUSY 4            //per mille
+#define BUS_SPI_WAIT 5            //per mille
+#define BUS_I2C_BYTES 6
+#define BUS_I2C_TRANSFERS 7
+#define BUS_I2C_BUSY 8
+#define BUS_I2C_WAIT 9
+
+unsigned int busReportStart = 0;  //T0TC the counts started from
+unsigned int busReportFrames = 0; //frameCount then
+#ifdef HOST_SIM
+unsigned int busSimUs[2];         //simBusUs() then
+#endif
+
+void busFigure(int figure, unsigned long long value)
+{
+    TRACE(TR_BUS, figure, (value > 0xFFFF) ? 0xFFFF : value);
+}
+
+//called with T0TC from the main loop, sends the figures once a second
+void busReport(unsigned int now)
+{
+    unsigned int us = now - busReportStart;
+    unsigned long long spiNs, i2cNs;
+
+    if (us < BUS_REPORT_US)
+    {
+        return;
+    }
+
+#ifdef HOST_SIM
+    for (int bus = 0; bus < 2; bus++)
+    {
+        unsigned int total = simBusUs(bus);
+
+        if (bus == 0)
+        {
+            busStat.spiWaitUs = total - busSimUs[0];
+        }
+        else
+        {
+            busStat.i2cWaitUs = total - busSimUs[1];
+        }
+        busSimUs[bus] = total;
+    }
+#endif
+
+    //SCK is CCLK / S0SPCCR, a byte is 8 of them; SCL is PCLK / (SCLH + SCLL)
+    spiNs = busStat.spiBytes * 8ULL * S0SPCCR * 1000000000ULL / cclkHz;
+    i2cNs = (busStat.i2cBytes * 9ULL + busStat.i2cTransfers * 2ULL) *
+            (I2C0SCLH + I2C0SCLL) * 1000000000ULL / pclkHz;
+
+    busFigure(BUS_FRAMES, frameCount - busReportFrames);
+    busFigure(BUS_SPI_BYTES, busStat.spiBytes);
+    busFigure(BUS_SPI_IDLE, busStat.spiIdle);
+    busFigure(BUS_SPI_TRANSFERS, busStat.spiTransfers);
+    busFigure(BUS_SPI_BUSY, spiNs / us);
+    busFigure(BUS_SPI_WAIT, busStat.spiWaitUs * 1000ULL / us);
+    busFigure(BUS_I2C_BYTES, busStat.i2cBytes);
+    busFigure(BUS_I2C_TRANSFERS, busStat.i2cTransfers);
+    busFigure(BUS_I2C_BUSY, i2cNs / us);
+    busFigure(BUS_I2C_WAIT, busStat.i2cWaitUs * 1000ULL / us);
+
+    busStat = {};
+    busReportStart = now;
+    busReportFrames = frameCount;
+}
+
+//**************************************************************************
+//gameplay capture
+//
+//built with CAPTURE_ENABLE, every frame sent to the display is recorded as
+//the XOR of it against the last one, run-length coded a page at a time, so
+//a frame where a few sprites moved costs a couple of dozen bytes instead
+//of GLCD_BYTES. the target keeps the newest CAPTURE_SIZE bytes of them in
+//a ring in the AHB SRAM (about 20 seconds of play), for a debugger to
+//pull out with
+//
+//    dump binary value capture.bin captureRing
+//
+//and the host sim streams them to the file named by SF_CAPTURE instead.
+//tools/sfvplay.c plays either back or turns it into a GIF
+//
+//a record is a byte with a bit per page that changed, a byte of
+//milliseconds since the previous frame (255 at most), then for each page
+//in the mask tokens covering its GLCD_WIDTH columns: 0x00-0x7F skips 1-128
+//unchanged columns, 0x80-0xFF is followed by 1-128 bytes to XOR in. a
+//file is "SFV1", width, pages, two zero bytes and records from a blank
+//screen
+
+#define CAPTURE_SIZE 16384        //ring bytes, a power of two up to 32kB
+#define CAPTURE_RECORD_MAX (2 + GLCD_PAGES * (GLCD_WIDTH * 3 / 2 + 1))
+
+//the ring with the screen from before its oldest record, so it always
+//decodes from the start. head and tail are free running byte counts
+struct captureRing
+{
+    char magic[4];                //"SFVR"
+    unsigned char width;
+    unsigned char pages;
+    unsigned short size;          //of data
+    unsigned int head;
+    unsigned int tail;
+    unsigned int frames;          //records in the ring
+    unsigned char base[GLCD_BYTES];
+    unsigned char data[CAPTURE_SIZE];
+};
+
+#ifdef CAPTURE_ENABLE
+#ifndef HOST_SIM
+RAM2_BSS struct captureRing captureRing;
+#endif
+RAM2_BSS unsigned char capturePrev[GLCD_BYTES];     //last frame recorded
+RAM2_BSS unsigned char captureRecord[CAPTURE_RECORD_MAX];
+unsigned int captureLast = 0;     //T0TC at the last frame
+int captureStarted = 0;
+
+//codes frame against prev into rec and brings prev up to date, returns
+//the record's length
+RAMFUNC int captureEncode(const char *frame, unsigned char *rec, unsigned char *prev)
+{
+    int n = 2;
+
+    rec[0] = 0;
+    for (int p = 0; p < GLCD_PAGES; p++)
+    {
+        const unsigned char *cur = (const unsigned char *)frame + p * GLCD_WIDTH;
+        unsigned char *old = prev + p * GLCD_WIDTH;
+        int start = n;
+        int changed = 0;
+        int c = 0;
+
+        while (c < GLCD_WIDTH)
+        {
+            int run = 0;
+            int lit = 0;
+            int at;
+
+            while ((c < GLCD_WIDTH) && (cur[c] == old[c]) && (run < 128))
+            {
+                run++;
+                c++;
+            }
+            if (run)
+            {
+                rec[n++] = run - 1;
+            }
+
+            at = n++;
+            while ((c < GLCD_WIDTH) && (cur[c] != old[c]) && (lit < 128))
+            {
+                rec[n++] = cur[c] ^ old[c];
+                old[c] = cur[c];
+                lit++;
+                c++;
+            }
+            if (lit)
+            {
+                rec[at] = 0x7F + lit;
+                changed = 1;
+            }
+            else
+            {
+                n--;
+            }
+        }
+
+        if (changed)
+        {
+            rec[0] |= 1 << p;
+        }
+        else
+        {
+            n = start;
+        }
+    }
+    return n;
+}
+
+#ifndef HOST_SIM
+//applies the oldest record to the base screen and drops it
+void captureEvict()
+{
+    struct captureRing *r = &captureRing;
+    unsigned int at = r->tail;
+    int mask = r->data[at++ & (CAPTURE_SIZE - 1)];
+
+    at++;                         //milliseconds
+    for (int p = 0; p < GLCD_PAGES; p++)
+    {
+        if (!(mask & (1 << p)))
+        {
+            continue;
+        }
+        for (int c = 0; c < GLCD_WIDTH;)
+        {
+            int token = r->data[at++ & (CAPTURE_SIZE - 1)];
+
+            if (token < 0x80)
+            {
+                c += token + 1;
+                continue;
+            }
+            for (int k = 0x7F; k < token; k++)
+            {
+                r->base[p * GLCD_WIDTH + c++] ^= r->data[at++ & (CAPTURE_SIZE - 1)];
+            }
+        }
+    }
+    r->tail = at;
+    r->frames--;
+}
+#endif
+#endif
+
+//records a frame on its way to the display
+RAMFUNC void captureFrame(const char *frame)
+{
+#ifdef CAPTURE_ENABLE
+    unsigned int now = T0TC;
+    unsigned int ms = (now - captureLast) / 1000;
+    int n;
+
+    if (!captureStarted)
+    {
+#ifdef HOST_SIM
+        const unsigned char header[8] = {'S', 'F', 'V', '1', GLCD_WIDTH, GLCD_PAGES, 0, 0};
+
+        simCapture(header, sizeof(header));
+#else
+        captureRing.magic[0] = 'S';
+        captureRing.magic[1] = 'F';
+        captureRing.magic[2] = 'V';
+        captureRing.magic[3] = 'R';
+        captureRing.width = GLCD_WIDTH;
+        captureRing.pages = GLCD_PAGES;
+        captureRing.size = CAPTURE_SIZE;
+#endif
+        ms = 0;
+        captureStarted = 1;
+    }
+    captureLast = now;
+
+    n = captureEncode(frame, captureRecord, capturePrev);
+    captureRecord[1] = (ms > 255) ? 255 : ms;
+
+#ifdef HOST_SIM
+    simCapture(captureRecord, n);
+#else
+    while (CAPTURE_SIZE - (captureRing.head - captureRing.tail) < (unsigned int)n)
+    {
+        captureEvict();
+    }
+    for (int i = 0; i < n; i++)
+    {
+        captureRing.data[captureRing.head++ & (CAPTURE_SIZE - 1)] = captureRecord[i];
+    }
+    captureRing.frames++;
+#endif
+#else
+    (void)frame;
+#endif
+}
+
+//*****************************************************************************
+//screen functions such as reset, clear, or updates and
+//also the user input checker
+
+//puts the whole game back to how it starts, with the difficulty setting
+//and a fresh seed for the wave script's random choices
+void reset()
+{
+    game = gameStart;
+    game.difficulty = logValue[KEY_DIFFICULTY];
+    game.waveSeed = T0TC | 1;
+}
+
+//set when output[] holds a finished frame for the display task, the game
+//doesn't touch output[] again until it's been sent
+int frameReady = 0;
+
+//displays outputs current values to the screen
+void updateScreen()
+{
+    captureFrame(output);
+    spiFault = 0;
+    display.flush(output, 0, 0, GLCD_WIDTH, GLCD_PAGES);
+    if (spiFault)
+    {
+        TRACE(TR_BUSFAULT, 2, busErr.spiTimeouts);
+    }
+}
+
+//sets all output values to that of what "would" be a blank screen, every
+//frame starts with it so it's in RAM with the rest of the update
+RAMFUNC void clrOutput()
+{
+    for (int m = 0; m < GLCD_BYTES; m++) 
+    {
+        output[m] = 0x00;
+    }
+}
+
+//sets all output values to zero then displays the blank screen
+void clrScreen()
+{
+    clrOutput();
+
+    updateScreen();
+}
+
+//outputs the home screen to the display
+//(the art is 5110 sized, larger panels get it centered on a blank screen)
+void displayHome()
+{
+    if ((GLCD_WIDTH != titleArt.width) || (GLCD_PAGES != titleArt.pages))
+    {
+        clrScreen();
+    }
+    else
+    {
+        captureFrame(titleArt.data);
+    }
+
+    display.flush(titleArt.data, (GLCD_WIDTH - titleArt.width) / 2,
+                  (GLCD_PAGES - titleArt.pages) / 2, titleArt.width, titleArt.pages);
+}
+
+//**************************************************************************
+//DAC audio
+//
+//built with AUDIO_DAC the sound comes out of the DAC (AOUT, p0.26) into a
+//small amp instead of the piezo on p2.0. GPDMA channel 0 copies samples
+//into DACR on the DAC's own timer from two half buffers linked to each
+//other in a ring, and its terminal count interrupt fills the half that
+//was just played from up to AUDIO_VOICES wavetable voices, each with a
+//pitch sweep and an attack/hold/release envelope. mixing a half with
+//every voice going is under 10k cycles, about 1% of the core
+//
+//the host sim has no DMA, so audioService() runs the same mixer off the
+//sim clock and hands the halves to simAudio(), which writes them to the
+//WAV file named by SF_AUDIO
+
+#ifdef AUDIO_DAC
+#define AUDIO_HZ 16000            //sample rate
+#define AUDIO_HALF 128            //samples in each half buffer (8ms)
+#define AUDIO_HALF_US (AUDIO_HALF * 1000000 / AUDIO_HZ)
+#define AUDIO_VOICES 4            //voice 0 is the theme, effects share the rest
+#define AUDIO_VOLUME_MAX 7        //KEY_VOLUME range, 0 is silent
+
+//waveforms
+#define WAVE_SINE 0
+#define WAVE_SQUARE 1
+#define WAVE_SAW 2
+#define WAVE_NOISE 3              //a new random level every period
+
+//envelope stages
+#define ENV_OFF 0
+#define ENV_ATTACK 1
+#define ENV_HOLD 2
+#define ENV_RELEASE 3
+#define ENV_HOLD_FOREVER 255      //hold until audioRelease()
+
+//what a sound is, times in half buffers (8ms)
+struct audioPatch
+{
+    unsigned char wave;
+    unsigned char level;          //peak, 0-255
+    unsigned char attack;
+    unsigned char hold;
+    unsigned char release;
+    unsigned short startHz;
+    unsigned short endHz;         //swept to linearly over the whole sound
+};
+
+struct audioVoice
+{
+    const signed char *wave;      //0 for noise
+    unsigned int phase;           //top 6 bits index the table
+    unsigned int step;            //phase added per sample
+    int slide;                    //step added per half buffer
+    int level;                    //envelope, 8.8 fixed point
+    int target;                   //level at the end of this half
+    unsigned char stage;
+    unsigned char blocks;         //half buffers left in the stage
+    unsigned char peak;
+    unsigned char hold;
+    unsigned char release;
+    signed char noise;            //held noise sample
+};
+
+//one cycle of a sine, the square and saw are filled in by audioInit()
+const signed char waveSine[64] = {
+    0, 12, 25, 37, 49, 60, 71, 81, 90, 98, 106, 112, 117, 122, 125, 126,
+    127, 126, 125, 122, 117, 112, 106, 98, 90, 81, 71, 60, 49, 37, 25, 12,
+    0, -12, -25, -37, -49, -60, -71, -81, -90, -98, -106, -112, -117, -122, -125, -126,
+    -127, -126, -125, -122, -117, -112, -106, -98, -90, -81, -71, -60, -49, -37, -25, -12,
+};
+signed char waveSquare[64];
+signed char waveSaw[64];
+
+//laser: a saw diving from a whine to a growl
+const struct audioPatch patchPew = {WAVE_SAW, 220, 0, 2, 12, 1800, 250};
+//explosion: noise sinking and dying away over about half a second
+const struct audioPatch patchHit = {WAVE_NOISE, 255, 0, 8, 50, 4000, 150};
+//theme notes, held by the sound task
+const struct audioPatch patchTheme = {WAVE_SQUARE, 160, 1, ENV_HOLD_FOREVER, 4, 0, 0};
+
+struct audioVoice voices[AUDIO_VOICES];
+unsigned int audioNoise = 1;      //LFSR for the noise voices
+int audioNextVoice = 1;           //effect voice to take next
+int audioNextHalf = 0;            //half buffer the DMA finishes next
+unsigned int audioClock = 0;      //sim clock at the last half mixed
+unsigned int audioDmaErrors = 0;
+
+//a DMA linked list item, read by the controller so it has to be in RAM
+//it can reach (the AHB SRAM) and word aligned
+struct dmaLli
+{
+    unsigned int src;
+    unsigned int dest;
+    unsigned int next;
+    unsigned int control;
+};
+
+RAM2_BSS unsigned int audioBuf[2][AUDIO_HALF];    //DACR words
+RAM2_BSS struct dmaLli audioLli[2];
+
+//phase step per sample for a frequency
+unsigned int audioStep(int hz)
+{
+    return (unsigned int)(((unsigned long long)hz << 32) / AUDIO_HZ);
+}
+
+//the level a voice reaches at the end of the coming half buffer, moving
+//it through its envelope
+RAMFUNC void audioEnvelope(struct audioVoice *v)
+{
+    v->level = v->target;
+
+    //moves on from the stages that are done
+    if ((v->stage == ENV_ATTACK) && (v->blocks == 0))
+    {
+        v->stage = ENV_HOLD;
+        v->blocks = v->hold;
+    }
+    if ((v->stage == ENV_HOLD) && (v->blocks == 0))
+    {
+        v->stage = ENV_RELEASE;
+        v->blocks = v->release;
+    }
+    if ((v->stage == ENV_RELEASE) && (v->blocks == 0))
+    {
+        v->stage = ENV_OFF;
+        v->level = 0;
+        v->target = 0;
+        return;
+    }
+
+    //straight lines to the peak and back to silence
+    if (v->stage == ENV_ATTACK)
+    {
+        v->target += ((v->peak << 8) - v->level) / v->blocks;
+    }
+    else if (v->stage == ENV_RELEASE)
+    {
+        v->target -= v->level / v->blocks;
+    }
+    else
+    {
+        v->target = v->peak << 8;
+    }
+    if ((v->stage != ENV_HOLD) || (v->hold != ENV_HOLD_FOREVER))
+    {
+        v->blocks--;
+    }
+    v->step += v->slide;
+}
+
+//fills a half buffer with DACR words, called by the DMA interrupt
+RAMFUNC void audioMix(unsigned int *buf)
+{
+    int mix[AUDIO_HALF];
+    int volume = logValue[KEY_VOLUME];
+
+    for (int i = 0; i < AUDIO_HALF; i++)
+    {
+        mix[i] = 0;
+    }
+
+    for (int n = 0; n < AUDIO_VOICES; n++)
+    {
+        struct audioVoice *v = &voices[n];
+        int level, ramp;
+
+        if (v->stage == ENV_OFF)
+        {
+            continue;
+        }
+        audioEnvelope(v);
+        level = v->level;
+        ramp = (v->target - v->level) / AUDIO_HALF;
+
+        for (int i = 0; i < AUDIO_HALF; i++)
+        {
+            unsigned int last = v->phase;
+            int sample;
+
+            v->phase += v->step;
+            if (v->wave)
+            {
+                sample = v->wave[v->phase >> 26];
+            }
+            else
+            {
+                if (v->phase < last)
+                {
+                    audioNoise = (audioNoise >> 1) ^ (-(audioNoise & 1) & 0xB400);
+                    v->noise = (signed char)audioNoise;
+                }
+                sample = v->noise;
+            }
+            mix[i] += (sample * (level >> 8)) >> 8;
+            level += ramp;
+        }
+    }
+
+    //a voice at full level swings +-127, the volume scales the mix into
+    //the DAC's 0-1023 around its midpoint (clipping only when several
+    //loud voices peak together near the top volume)
+    if (volume > AUDIO_VOLUME_MAX)
+    {
+        volume = AUDIO_VOLUME_MAX;
+    }
+    for (int i = 0; i < AUDIO_HALF; i++)
+    {
+        int value = 512 + (mix[i] * volume) / 4;
+
+        if (value < 0)
+        {
+            value = 0;
+        }
+        else if (value > 1023)
+        {
+            value = 1023;
+        }
+        buf[i] = value << 6;
+    }
+}
+
+//voices are shared with the interrupt, so it's held off while one changes
+void audioLock()
+{
+    ICER0 = (1<<DMA_IRQ);
+}
+
+void audioUnlock()
+{
+    ISER0 = (1<<DMA_IRQ);
+}
+
+//starts a patch on a voice, hz of 0 uses the patch's own sweep
+void audioPlay(int voice, const struct audioPatch *patch, int hz)
+{
+    struct audioVoice *v = &voices[voice];
+    int blocks = patch->attack + patch->release +
+                 ((patch->hold == ENV_HOLD_FOREVER) ? 0 : patch->hold);
+    unsigned int start = audioStep(hz ? hz : patch->startHz);
+    unsigned int end = hz ? start : audioStep(patch->endHz);
+
+    audioLock();
+    v->stage = ENV_OFF;
+    v->wave = (patch->wave == WAVE_SINE) ? waveSine :
+              (patch->wave == WAVE_SQUARE) ? waveSquare :
+              (patch->wave == WAVE_SAW) ? waveSaw : 0;
+    v->step = start;
+    v->slide = blocks ? ((int)end - (int)start) / blocks : 0;
+    v->peak = patch->level;
+    v->hold = patch->hold;
+    v->release = patch->release;
+    v->level = 0;
+    v->target = 0;
+    v->blocks = patch->attack;    //even with no attack it ramps up over
+    v->stage = ENV_ATTACK;        //the first half buffer, so no click
+    audioUnlock();
+}
+
+//lets a held voice go into its release
+void audioRelease(int voice)
+{
+    struct audioVoice *v = &voices[voice];
+
+    audioLock();
+    if ((v->stage == ENV_ATTACK) || (v->stage == ENV_HOLD))
+    {
+        v->stage = ENV_RELEASE;
+        v->blocks = v->release;
+    }
+    audioUnlock();
+}
+
+//effects take the effect voices in turn, cutting off the oldest
+void audioEffect(const struct audioPatch *patch)
+{
+    audioPlay(audioNextVoice, patch, 0);
+    if (++audioNextVoice == AUDIO_VOICES)
+    {
+        audioNextVoice = 1;
+    }
+}
+
+#ifndef HOST_SIM
+//a half buffer has played, refill it while the DMA plays the other
+extern "C" RAMFUNC void DMA_IRQHandler(void)
+{
+    if (DMACIntErrStat & (1<<0))
+    {
+        DMACIntErrClr = (1<<0);
+        audioDmaErrors++;
+    }
+    if (DMACIntTCStat & (1<<0))
+    {
+        DMACIntTCClear = (1<<0);
+        audioMix(audioBuf[audioNextHalf]);
+        audioNextHalf ^= 1;
+    }
+}
+#endif
+
+void audioInit()
+{
+    for (int i = 0; i < 64; i++)
+    {
+        waveSquare[i] = (i < 32) ? 127 : -127;
+        waveSaw[i] = (signed char)(i * 4 - 128);
+    }
+    audioClock = T0TC;
+
+#ifndef HOST_SIM
+    {
+        //word transfers of a half buffer, source incrementing, interrupt
+        //at the end of each
+        unsigned int control = AUDIO_HALF | (2<<18) | (2<<21) | (1<<26) | (1u<<31);
+
+        audioMix(audioBuf[0]);
+        audioMix(audioBuf[1]);
+        for (int i = 0; i < 2; i++)
+        {
+            audioLli[i].src = (unsigned int)audioBuf[i];
+            audioLli[i].dest = DACR_ADDR;
+            audioLli[i].next = (unsigned int)&audioLli[i ^ 1];
+            audioLli[i].control = control;
+        }
+
+        PINSEL1 = (PINSEL1 & ~(3<<20)) | (2<<20);    //p0.26 as AOUT
+        PINMODE1 = (PINMODE1 & ~(3<<20)) | (2<<20);  //no pull resistors
+        DACR = 512 << 6;
+
+        PCONP |= (1<<29);                            //GPDMA
+        DMACConfig = (1<<0);
+        DMACIntTCClear = (1<<0);
+        DMACIntErrClr = (1<<0);
+        DMACC0SrcAddr = audioLli[0].src;
+        DMACC0DestAddr = DACR_ADDR;
+        DMACC0LLI = audioLli[0].next;
+        DMACC0Control = control;
+        //memory to the DAC (request 7), error and terminal count interrupts
+        DMACC0Config = (1<<0) | (7<<6) | (1<<11) | (1<<14) | (1<<15);
+
+        DACCNTVAL = pclkHz / AUDIO_HZ;                //PCLK_DAC is CCLK/4
+        DACCTRL = (1<<1) | (1<<2) | (1<<3);           //double buffer, count, DMA
+        ISER0 = (1<<DMA_IRQ);
+    }
+#endif
+}
+
+#ifdef HOST_SIM
+//mixes the halves the DMA would have played by now
+void audioService()
+{
+    static unsigned int buf[AUDIO_HALF];
+
+    while (T0TC - audioClock >= AUDIO_HALF_US)
+    {
+        audioMix(buf);
+        simAudio(buf, AUDIO_HALF);
+        audioClock += AUDIO_HALF_US;
+    }
+}
+#endif
+#endif
+
+//*********************************************************************************
+//Final game functions and music:
+//checks for presses, wins, fire laser, noise output, and game loop
+
+//sets the expander's port A up as inputs, left until the first read so
+//it stays off the boot path
+void expanderInit()
+{
+    i2cFault = 0;
+    start();
+    write(expWrite);
+    write(DIRA);
+    write(0xFF); //write 1's to DIRA to activate as input pins
+    stop();
+
+    start();
+    write(expWrite);
+    write(GPPUA);
+    write(0x00); //write 0's to GPPUA to turn off pull up resistors;
+    stop();
+
+    expanderReady = !i2cFault;
+}
+
+//checks the data values read from the I/O expander (serial input)
+//and sets it equal to the input value. if the bus has failed, inputVal
+//keeps the last good sample until the expander answers again
+void checkIn()
+{
+    int last = inputVal;
+    int value = 0;
+
+    if (i2cHoldoff > 0)
+    {
+        i2cHoldoff--;
+        busErr.degradedPolls++;
+        return;
+    }
+
+    if (!expanderReady)
+    {
+        expanderInit();
+    }
+
+    if (expanderReady)
+    {
+        i2cFault = 0;
+        start();
+        write(expWrite);
+        write(GPIOA);
+        stop();
+
+        start();
+        write(expRead);
+        value = read(0);
+        stop();
+    }
+
+    if (i2cFault || !expanderReady)
+    {
+        TRACE(TR_BUSFAULT, 1, busErr.i2cTimeouts + busErr.i2cNacks);
+        i2cRecover();
+        i2cFault = 0;
+        i2cHoldoff = i2cBackoff;
+        if (i2cBackoff < I2C_MAX_BACKOFF)
+        {
+            i2cBackoff *= 2;
+        }
+        busErr.degradedPolls++;
+        return;
+    }
+    i2cBackoff = 1;
+
+    inputVal = value;
+    if (inputVal != last)
+    {
+        TRACE(TR_INPUT, inputVal, last);
+    }
+}
+
+#ifdef AUDIO_DAC
+//the theme on its own voice, halfPeriod in microseconds
+void toneStart(int halfPeriod)
+{
+    audioPlay(0, &patchTheme, 500000 / halfPeriod);
+}
+
+void toneStop()
+{
+    audioRelease(0);
+}
+#else
+//background tone on the piezo: timer 1 (1MHz like timer 0) interrupts
+//every half period and the handler flips P2.0
+extern "C" RAMFUNC void TIMER1_IRQHandler(void)
+{
+    T1IR = (1<<0);          //clears the MR0 interrupt
+    FIO2PIN ^= (1<<0);
+}
+
+//halfPeriod in microseconds
+void toneStart(int halfPeriod)
+{
+    T1TCR = (1<<1);         //hold in reset while it's set up
+    T1PR = TIMER_PRESCALE;
+    T1MR0 = halfPeriod;
+    T1MCR = (1<<0) | (1<<1); //interrupt and restart on MR0
+    T1TCR = (1<<0);
+    ISER0 = (1<<TIMER1_IRQ);
+}
+
+void toneStop()
+{
+    ICER0 = (1<<TIMER1_IRQ);
+    T1TCR = 0;
+    FIO2PIN &= ~(1<<0);
+}
+#endif
+
+//the tunes are written in half periods of 2.5us units, what a busy loop
+//took when the piezo was bit-banged on the 4MHz IRC. toneStart() wants
+//microseconds
+#define TICK_NS 2500
+
+//the imperial theme, played by the sound task while themeNote is below 18
+int themeNote = 18;         //current note, 18 when finished
+
+//the quarter notes are shorter, everything else is held twice as long
+int themeNoteLength(int note)
+{
+    if ((note == 4) || (note == 7) || (note == 13) || (note ==16) ||
+            (note == 3) || (note == 6) || (note == 12) || (note ==15))
+    {
+        return 200000;
+    }
+    return 400000;
+}
+
+void themeStart()
+{
+    T0TCR |= (1<<0);
+    themeNote = 0;
+}
+
+void themeStop()
+{
+    themeNote = 18;
+    toneStop();
+}
+
+//effects waiting for the sound task. on the piezo they play one after
+//another as plain tones and cut in ahead of the theme, the DAC mixes them
+//over it
+#define EFFECT_QUEUE 4            //a power of two
+#define EFFECT_US 100000          //piezo tones last 100ms
+
+#define EFFECT_PEW 0
+#define EFFECT_HIT 1
+
+int effectQueue[EFFECT_QUEUE];
+unsigned int effectHead = 0;
+unsigned int effectTail = 0;
+
+void effectPlay(int effect)
+{
+    if (effectHead - effectTail < EFFECT_QUEUE)
+    {
+        effectQueue[effectHead & (EFFECT_QUEUE - 1)] = effect;
+        effectHead++;
+    }
+}
+
+//the sound task's side, a mixed voice or the piezo tone
+void effectStart(int effect)
+{
+#ifdef AUDIO_DAC
+    audioEffect((effect == EFFECT_HIT) ? &patchHit : &patchPew);
+#else
+    toneStart(((effect == EFFECT_HIT) ? hitNoise[0] : pewNoise[0]) * TICK_NS / 1000);
+#endif
+}
+
+//plays laser noise
+void pewPew()
+{
+    effectPlay(EFFECT_PEW);
+}
+
+//
+void targetHit()
+{
+    effectPlay(EFFECT_HIT);
+}
+
+//**************************************************************************
+//wave scripts
+//
+//single player's waves, assembled by tools/wavec.c from assets/waves.txt.
+//comeAtMeBro() in rules.h runs them
+#include "waves.inc"
+
+//the rules' hooks, a pew for each shot and two for a wave
+static RAMFUNC void rulesShot(int player, int pos)
+{
+    TRACE(TR_FIRE, player, pos);
+    pewPew();
+}
+
+static RAMFUNC void rulesWave(int page, int mask)
+{
+    pewPew();
+    pewPew();
+    TRACE(TR_WAVE, page, mask);
+}
+
+//**************************************************************************
+//the game pipeline
+//
+//every mode moves, draws and hit tests through the same few templates
+//around the laser rules in rules.h, and what differs between modes is a
+//policy struct handed in as the template parameter:
+//
+//  ships        1, or 2 with player 2 facing left on the right
+//  scored       1 if the score is frames survived
+//  lasers       how many of laser1, laser11, laser2, laser21 it uses
+//  rightward    how many of those, from laser1 on, fly right at player 2,
+//               the rest fly left at player 1
+//  tick()       input and whatever fires, before the frame is drawn
+//  update()     anything else to move and draw, returns a ship it hit
+//  over(ship)   trace and saved scores for the game ending with ship hit
+//
+//the numbers are compile time constants, so each mode gets its own copy
+//of the loops with its laser directions built in and no tests of which
+//mode it is. a new mode is a new policy and a RAMFUNC that runs its
+//gameMove<>() for gameTask()
+
+//draws laser k and moves it on a pixel, if it's out
+template <class mode, int k>
+RAMINLINE void laserUpdate(short *laser)
+{
+    if ((k < mode::lasers) && (laser[3] == 1))
+    {
+        spritePut(output, laser[0], laserSprite.art[0]);
+
+        laserMove(laser, k < mode::rightward);
+    }
+}
+
+//laserStrike() for laser k, if the mode uses it
+template <class mode, int k>
+RAMINLINE int laserHit(const short *laser, int *at)
+{
+    return (k < mode::lasers) ? laserStrike(&game, laser, k < mode::rightward, at) : 0;
+}
+
+//laserPark() for laser k, if the mode uses it
+template <class mode, int k>
+RAMINLINE void laserMissed(short *laser)
+{
+    if (k < mode::lasers)
+    {
+        laserPark(&game, laser, k < mode::rightward);
+    }
+}
+
+//updates the screen with current object positions, moving the lasers on,
+//and returns the ship update() hit if any
+template <class mode>
+RAMINLINE int updateGame()
+{
+    int ship;
+
+    //clears output to erase previous object positions
+    //before rewriting them
+    clrOutput();
+
+    spritePut(output, game.tieFighter1[0], tieSprite.art[0]);
+    if (mode::ships == 2)
+    {
+        spritePut(output, game.tieFighter2[0], tieSprite.mirrored[0]);
+    }
+
+    laserUpdate<mode, 0>(game.laser1);
+    laserUpdate<mode, 1>(game.laser11);
+    laserUpdate<mode, 2>(game.laser2);
+    laserUpdate<mode, 3>(game.laser21);
+    ship = mode::update();
+
+    //hands the frame to the display task
+    frameReady = 1;
+    return ship;
+}
+
+//the ship the first laser to get there has hit (laser1, laser11, laser2,
+//laser21 order), or 0
+template <class mode>
+RAMINLINE int gameHit(int *at)
+{
+    int ship = laserHit<mode, 0>(game.laser1, at);
+
+    ship = ship ? ship : laserHit<mode, 1>(game.laser11, at);
+    ship = ship ? ship : laserHit<mode, 2>(game.laser2, at);
+    ship = ship ? ship : laserHit<mode, 3>(game.laser21, at);
+    return ship;
+}
+
+//checks positions of objects for hits/wins
+//and also clears lasers if they have reached bounds without a hit
+template <class mode>
+RAMINLINE void gameOver(int ship)
+{
+    int at = game.tieFighter1[0];
+
+    ship = ship ? ship : gameHit<mode>(&at);
+    if (ship)
+    {
+        TRACE(TR_HIT, ship, at);
+        mode::over(ship);
+        targetHit();
+        game.gameOver = 1;
+        return;
+    }
+
+    laserMissed<mode, 0>(game.laser1);
+    laserMissed<mode, 1>(game.laser11);
+    laserMissed<mode, 2>(game.laser2);
+    laserMissed<mode, 3>(game.laser21);
+}
+
+//one tick of a mode
+template <class mode>
+RAMINLINE void gameMove()
+{
+    if (mode::scored && (game.score < 0xFFFF))
+    {
+        game.score++;
+    }
+    mode::tick();
+    gameOver<mode>(updateGame<mode>());
+}
+
+//single player laser dodge, the wave script's lasers all fly left
+struct singleMode
+{
+    static constexpr int ships = 1;
+    static constexpr int scored = 1;
+    static constexpr int lasers = 4;
+    static constexpr int rightward = 0;
+
+    static RAMINLINE void tick()
+    {
+        comeAtMeBro(&game, waveScript);
+        soloInput(&game, game.input);
+    }
+
+    static RAMINLINE int update()
+    {
+        return 0;
+    }
+
+    //ahhh you've been shot!
+    static void over(int)
+    {
+        TRACE(TR_GAMEOVER, 1, game.score);
+        if (game.score > logValue[KEY_HISCORE])
+        {
+            logPut(KEY_HISCORE, game.score);
+        }
+    }
+};
+
+//multiplayer, two lasers each, player 1's fly right
+struct multMode
+{
+    static constexpr int ships = 2;
+    static constexpr int scored = 0;
+    static constexpr int lasers = 4;
+    static constexpr int rightward = 2;
+
+    static RAMINLINE void tick()
+    {
+        multInput(&game, game.input);
+    }
+
+    static RAMINLINE int update()
+    {
+        return 0;
+    }
+
+    //the player whose ship wasn't hit wins
+    static void over(int ship)
+    {
+        TRACE(TR_GAMEOVER, 2, 3 - ship);
+        if (ship == 2)
+        {
+            logPut(KEY_P1WINS, logValue[KEY_P1WINS] + 1);
+        }
+        else
+        {
+            logPut(KEY_P2WINS, logValue[KEY_P2WINS] + 1);
+        }
+    }
+};
+
+//**************************************************************************
+//endurance mode
+//
+//P1 fire on the title starts a bullet hell survival run. emitters drift up
+//and down the right edge spraying single pixel bullets, more of them and
+//more often as the run goes on, and the ship dodges a page at a time like
+//single player until a bullet touches it. the bullets are too many for
+//gameState, so snapshots don't cover them
+//
+//positions and speeds are in 1/16 pixels. each tick the live bullets are
+//counting sorted into a grid of cells a page tall and GRID_COLS columns
+//wide, and the hit test only walks the cells under the ship, so it costs
+//however many bullets are near the ship rather than all of them
+
+#define MODE_ENDURANCE 32         //inputVal that starts a run
+#define BULLET_MAX 512
+#define EMITTERS 4
+#define EMITTER_X (GLCD_WIDTH - 3)
+#define GRID_COLS 8
+#define GRID_WIDTH ((GLCD_WIDTH + GRID_COLS - 1) / GRID_COLS)
+#define GRID_CELLS (GRID_WIDTH * GLCD_PAGES)
+#define SUB 16                    //fixed point steps per pixel
+#define LEVEL_TICKS 250           //ticks per level, 10s at the start
+
+//volleys
+#define EMIT_FAN 0                //seven spread out
+#define EMIT_AIMED 1              //three at the ship
+#define EMIT_SWEEP 2              //four, swinging further round each volley
+#define EMIT_KINDS 3
+
+struct bullet
+{
+    short x;
+    short y;
+    signed char dx;
+    signed char dy;
+};
+
+struct emitter
+{
+    short y;                      //top of its ball sprite, in 1/16 pixels
+    signed char dy;
+    unsigned char kind;
+    unsigned char timer;          //ticks to the next volley
+    unsigned char swing;          //EMIT_SWEEP's place in sweepDir
+};
+
+RAM2_BSS struct bullet bullets[BULLET_MAX];
+RAM2_BSS unsigned short gridOrder[BULLET_MAX];     //bullets sorted by cell
+unsigned short gridStart[GRID_CELLS + 1];          //each cell's first gridOrder slot
+int bulletCount = 0;
+struct emitter emitters[EMITTERS];
+
+//directions about a pixel a tick long, up-left round to down-left and back
+const signed char sweepDir[12][2] = {
+    {-6, -15}, {-11, -11}, {-15, -6}, {-16, 0}, {-15, 6}, {-11, 11},
+    {-6, 15}, {-11, 11}, {-15, 6}, {-16, 0}, {-15, -6}, {-11, -11}
+};
+
+void enduranceReset()
+{
+    bulletCount = 0;
+    for (int e = 0; e < EMITTERS; e++)
+    {
+        emitters[e].y = ((GLCD_PAGES * 8 - 8) * (2 * e + 1) / (2 * EMITTERS)) * SUB;
+        emitters[e].dy = (e & 1) ? -SUB / 2 : SUB / 2;
+        emitters[e].kind = e % EMIT_KINDS;
+        emitters[e].timer = 1 + 7 * e;
+        emitters[e].swing = 0;
+    }
+}
+
+//a bullet into the pool, dropped if it's full
+void bulletAdd(int x, int y, int dx, int dy)
+{
+    if (bulletCount < BULLET_MAX)
+    {
+        struct bullet *b = &bullets[bulletCount++];
+
+        b->x = x;
+        b->y = y;
+        b->dx = (dx < -127) ? -127 : (dx > 127) ? 127 : dx;
+        b->dy = (dy < -127) ? -127 : (dy > 127) ? 127 : dy;
+    }
+}
+
+//difficulty and the time survived, levels add emitters, volleys and bullet
+//speed until they top out
+int enduranceLevel()
+{
+    return game.score / LEVEL_TICKS + game.difficulty;
+}
+
+int emittersActive(int level)
+{
+    return (2 + level / 2 < EMITTERS) ? 2 + level / 2 : EMITTERS;
+}
+
+//moves the emitters that are in play and fires the ones that are due
+RAMFUNC void emittersRun()
+{
+    int level = enduranceLevel();
+    int active = emittersActive(level);
+    int period = (16 - level > 3) ? 16 - level : 3;
+    int speed = (SUB / 2 + level < SUB * 3 / 4) ? SUB / 2 + level : SUB * 3 / 4;
+    int shipY = (game.tieFighter1[0] / GLCD_WIDTH) * 8 + 4;
+
+    for (int e = 0; e < active; e++)
+    {
+        struct emitter *m = &emitters[e];
+        int x = (EMITTER_X - 1) * SUB;
+        int y = m->y + 3 * SUB;   //middle of the ball
+        int aim;
+
+        m->y += m->dy;
+        if ((m->y <= 0) || (m->y >= (GLCD_PAGES * 8 - 8) * SUB))
+        {
+            m->dy = -m->dy;
+        }
+        if (--m->timer)
+        {
+            continue;
+        }
+        m->timer = period + (waveRandom(&game) & 3);
+
+        switch (m->kind)
+        {
+            case EMIT_FAN:
+                for (int k = -3; k <= 3; k++)
+                {
+                    bulletAdd(x, y, -speed, k * speed / 4);
+                }
+                break;
+            case EMIT_AIMED:
+                //dy for the bullet to cross the ship's middle row as it
+                //reaches the ship's columns
+                aim = (shipY * SUB - y) * speed / ((EMITTER_X - 6) * SUB);
+                for (int k = -1; k <= 1; k++)
+                {
+                    bulletAdd(x, y, -speed, aim + k * 2);
+                }
+                break;
+            case EMIT_SWEEP:
+                for (int k = 0; k < 4; k++)
+                {
+                    const signed char *d = sweepDir[(m->swing + 3 * k) % 12];
+
+                    bulletAdd(x, y, d[0] * speed / SUB, d[1] * speed / SUB);
+                }
+                m->swing = (m->swing + 1) % 12;
+                break;
+        }
+        m->kind = (m->kind + 1 + (waveRandom(&game) & 1)) % EMIT_KINDS;
+    }
+}
+
+//moves the bullets, drops the ones that left the screen (the last one
+//fills the gap), sorts the rest into the grid and draws them. returns 1
+//if one is touching the ship
+RAMFUNC int bulletUpdate()
+{
+    int x0 = game.tieFighter1[0] % GLCD_WIDTH;
+    int page = game.tieFighter1[0] / GLCD_WIDTH;
+
+    for (int c = 0; c <= GRID_CELLS; c++)
+    {
+        gridStart[c] = 0;
+    }
+
+    for (int i = 0; i < bulletCount;)
+    {
+        struct bullet *b = &bullets[i];
+
+        b->x += b->dx;
+        b->y += b->dy;
+        if ((b->x < 0) || (b->x >= GLCD_WIDTH * SUB) || (b->y < 0) ||
+                (b->y >= GLCD_PAGES * 8 * SUB))
+        {
+            *b = bullets[--bulletCount];
+            continue;
+        }
+        gridStart[(b->y / (8 * SUB)) * GRID_WIDTH + b->x / (GRID_COLS * SUB) + 1]++;
+        output[(b->y / (8 * SUB)) * GLCD_WIDTH + b->x / SUB] |= 1 << ((b->y / SUB) & 7);
+        i++;
+    }
+
+    //counts to starts, then each bullet bumps its cell's start along, which
+    //leaves every start where the next cell's began
+    for (int c = 0; c < GRID_CELLS; c++)
+    {
+        gridStart[c + 1] += gridStart[c];
+    }
+    for (int i = 0; i < bulletCount; i++)
+    {
+        int cell = (bullets[i].y / (8 * SUB)) * GRID_WIDTH + bullets[i].x / (GRID_COLS * SUB);
+
+        gridOrder[gridStart[cell]++] = i;
+    }
+    for (int c = GRID_CELLS; c > 0; c--)
+    {
+        gridStart[c] = gridStart[c - 1];
+    }
+    gridStart[0] = 0;
+
+    //only the cells the ship's columns cross
+    for (int bin = x0 / GRID_COLS; bin <= (x0 + tieSprite.width - 1) / GRID_COLS; bin++)
+    {
+        int cell = page * GRID_WIDTH + bin;
+
+        for (int k = gridStart[cell]; k < gridStart[cell + 1]; k++)
+        {
+            const struct bullet *b = &bullets[gridOrder[k]];
+            int col = b->x / SUB - x0;
+
+            if ((col >= 0) && (col < tieSprite.width) &&
+                    (tieSprite.mask[0][col] & (1 << ((b->y / SUB) & 7))))
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+//endurance, no lasers, the emitters and bullets are update()
+struct enduranceMode
+{
+    static constexpr int ships = 1;
+    static constexpr int scored = 1;
+    static constexpr int lasers = 0;
+    static constexpr int rightward = 0;
+
+    static RAMINLINE void tick()
+    {
+        emittersRun();
+        soloInput(&game, game.input);
+    }
+
+    //draws the emitters, then bulletUpdate()
+    static RAMINLINE int update()
+    {
+        int active = emittersActive(enduranceLevel());
+
+        for (int e = 0; e < active; e++)
+        {
+            spriteDraw(output, GLCD_WIDTH, GLCD_PAGES, EMITTER_X, emitters[e].y / SUB, ballSprite);
+        }
+        return bulletUpdate();
+    }
+
+    static void over(int)
+    {
+        TRACE(TR_GAMEOVER, 3, game.score);
+        if (game.score > logValue[KEY_ENDURANCE])
+        {
+            logPut(KEY_ENDURANCE, game.score);
+        }
+    }
+};
+
+//**************************************************************************
+//cycle benchmark
+//
+//built with BENCH defined, main() plays BENCH_FRAMES single player frames
+//with a scripted pilot before the title goes up, counting DWT cycles for
+//the game update (wave, move, drawing, hit test) and for the display
+//flush. the min, average and max go out as TR_BENCH records (cycles / 16)
+//along with where the hot paths were; build it with and without
+//FLASH_ONLY to compare
+//
+//stressRun() follows with the endurance update and flush, the bullet pool
+//held at STRESS_STEP, 2 x STRESS_STEP ... BULLET_MAX bullets for
+//STRESS_FRAMES frames each. it reports the most bullets whose worst frame
+//still fit FRAME_BUDGET, and where a line through the first and last
+//steps' worst frames crosses it for when the pool runs out first. the
+//host sim runs the same thing against its own clock
+#ifdef BENCH
+
+#define BENCH_FRAMES 256
+#define BENCH_UPDATE 0              //sections (high nibble of a)
+#define BENCH_FLUSH 1
+#define BENCH_STRESS 2              //b is bullets (0, 1) or cycles / 16 (2)
+#define STRESS_STEP 32
+#define STRESS_FRAMES 32
+#define BENCH_PLACEMENT 15          //b is 1 with the hot paths in RAM
+
+struct benchStat
+{
+    unsigned int min;
+    unsigned int max;
+    unsigned int total;
+};
+
+void benchAdd(struct benchStat *b, unsigned int cycles)
+{
+    if (cycles < b->min)
+    {
+        b->min = cycles;
+    }
+    if (cycles > b->max)
+    {
+        b->max = cycles;
+    }
+    b->total += cycles;
+}
+
+//one record per figure, low nibble of a is 0 average, 1 min, 2 max
+void benchReport(int section, const struct benchStat *b)
+{
+    unsigned int figure[3] = {b->total / BENCH_FRAMES, b->min, b->max};
+
+    for (int k = 0; k < 3; k++)
+    {
+        unsigned int sixteenths = figure[k] >> 4;
+
+        TRACE(TR_BENCH, (section << 4) | k, (sixteenths > 0xFFFF) ? 0xFFFF : sixteenths);
+    }
+}
+
+//a single player tick without the score or the game over, returns the
+//ship hit like gameHit()
+RAMFUNC int benchTick()
+{
+    int at;
+
+    singleMode::tick();
+    updateGame<singleMode>();
+    return gameHit<singleMode>(&at);
+}
+
+//an endurance frame, the hit test included but not acted on
+RAMFUNC void stressTick()
+{
+    updateGame<enduranceMode>();
+}
+
+void benchRun()
+{
+    struct benchStat update = {0xFFFFFFFF, 0, 0};
+    struct benchStat flush = {0xFFFFFFFF, 0, 0};
+    static const int stick[3] = {0, 128, 64};
+    unsigned int seed = 1;
+    unsigned int t0;
+
+    DEMCR |= (1<<24);               //trace enable, turns the DWT on
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= (1<<0);             //cycle counter on
+
+    reset();
+    for (int f = 0; f < BENCH_FRAMES; f++)
+    {
+        //holds up, down or nothing for a few frames at a time
+        if ((f % 4) == 0)
+        {
+            seed = seed * 1103515245 + 12345;
+            game.input = stick[(seed >> 16) % 3];
+        }
+
+        t0 = DWT_CYCCNT;
+        if (benchTick())
+        {
+            reset();
+        }
+        benchAdd(&update, DWT_CYCCNT - t0);
+
+        t0 = DWT_CYCCNT;
+        display.flush(output, 0, 0, GLCD_WIDTH, GLCD_PAGES);
+        benchAdd(&flush, DWT_CYCCNT - t0);
+
+        traceDrain();
+    }
+
+    //the waves' trace records have to clear the ring to make room
+    while (traceTail != traceHead)
+    {
+        traceDrain();
+    }
+#ifdef FLASH_ONLY
+    TRACE(TR_BENCH, BENCH_PLACEMENT << 4, 0);
+#else
+    TRACE(TR_BENCH, BENCH_PLACEMENT << 4, 1);
+#endif
+    benchReport(BENCH_UPDATE, &update);
+    benchReport(BENCH_FLUSH, &flush);
+
+    frameReady = 0;
+    game.input = 0;
+    effectTail = effectHead;        //drops the pews the waves queued
+    reset();
+}
+
+void stressRun()
+{
+    unsigned int budget = (cclkHz / 1000000) * FRAME_BUDGET;
+    unsigned int first = 0, worst = 0, perBullet, t0;
+    unsigned int seed = 1;
+    int sustained = 0, projected = 0xFFFF;
+
+    reset();
+    enduranceReset();
+    for (int n = STRESS_STEP; n <= BULLET_MAX; n += STRESS_STEP)
+    {
+        worst = 0;
+        for (int f = 0; f < STRESS_FRAMES; f++)
+        {
+            //tops the pool back up with bullets anywhere on the screen
+            while (bulletCount < n)
+            {
+                int x, y;
+
+                seed = seed * 1103515245 + 12345;
+                x = (seed >> 16) % (GLCD_WIDTH * SUB);
+                seed = seed * 1103515245 + 12345;
+                y = (seed >> 16) % (GLCD_PAGES * 8 * SUB);
+                bulletAdd(x, y, -SUB - (int)(seed & 15), (int)((seed >> 8) & 31) - 16);
+            }
+
+            t0 = DWT_CYCCNT;
+            stressTick();
+            display.flush(output, 0, 0, GLCD_WIDTH, GLCD_PAGES);
+            t0 = DWT_CYCCNT - t0;
+            if (t0 > worst)
+            {
+                worst = t0;
+            }
+            traceDrain();
+        }
+
+        if (n == STRESS_STEP)
+        {
+            first = worst;
+        }
+        if (worst <= budget)
+        {
+            sustained = n;
+        }
+    }
+
+    perBullet = (worst > first) ? (worst - first) / (BULLET_MAX - STRESS_STEP) : 0;
+    if (perBullet && (first < budget) && ((budget - first) / perBullet < 0xFFFF - STRESS_STEP))
+    {
+        projected = STRESS_STEP + (budget - first) / perBullet;
+    }
+    else if (first >= budget)
+    {
+        projected = 0;
+    }
+
+    TRACE(TR_BENCH, BENCH_STRESS << 4, sustained);
+    TRACE(TR_BENCH, (BENCH_STRESS << 4) | 1, projected);
+    TRACE(TR_BENCH, (BENCH_STRESS << 4) | 2, (worst / 16 > 0xFFFF) ? 0xFFFF : worst / 16);
+
+    frameReady = 0;
+    enduranceReset();
+    reset();
+}
+#endif
+
+//boot trace, timer 0 microseconds at each stage of bring-up. timer 0 is
+//started as soon as the clock is up so these are close to time from reset
+#define BOOT_TIMER 0        //timer running
+#define BOOT_DISPLAY 1      //SPI and panel initialized
+#define BOOT_TITLE 2        //title screen on the glass
+#define BOOT_INPUT 3        //I2C and piezo ready
+#define BOOT_INTERACTIVE 4  //first controller read done
+#define BOOT_STAGES 5
+
+unsigned int bootTime[BOOT_STAGES];
+
+void bootMark(int stage)
+{
+    bootTime[stage] = T0TC;
+    TRACE(TR_BOOT, stage, GLCD_WIDTH);
+#ifdef HOST_SIM
+    if (stage == BOOT_INTERACTIVE)
+    {
+        for (int b = 0; b < BOOT_STAGES; b++)
+        {
+            fprintf(stderr, "boot stage %d: %u us\n", b, bootTime[b]);
+        }
+    }
+#endif
+}
+
+//**************************************************************************
+//cooperative tasks
+//
+//the game runs as four protothreads that playGame() gives a turn each, in
+//a loop: input samples the controller, game runs the title and the waves,
+//display sends finished frames out and sound sequences the piezo. a task
+//is a function that keeps its place in lc, the TASK_ macros return while
+//whatever it's waiting for (a timer 0 deadline, a frame to send) isn't
+//ready and jump back to the same line on its next turn. locals don't
+//survive a wait, so anything kept across one is a global, and there can
+//only be one wait per source line (the line number is the resume point)
+//
+//every turn is timed on timer 0 and charged to its task, or to idle if
+//all it did was find its wait still not ready, so the table shows which
+//task is using the frame: TR_TASK records at the end of each frame, and
+//the host sim prints the totals after every game
+
+#define INPUT_US 10000            //controller sampling period
+#define GAME_OVER_US 2000000      //game over screen before the title
+
+struct task
+{
+    const char *name;
+    void (*run)(struct task *t);
+    int lc;                       //line to resume at, 0 is the top
+    int busy;                     //did some work this turn
+    unsigned int wake;            //deadline for TASK_SLEEP
+    unsigned int frameUs;         //run time in the current frame
+    unsigned int worstUs;         //most run time in any one frame
+    unsigned int totalUs;
+};
+
+#define TASK_BEGIN(t) switch ((t)->lc) { case 0:
+#define TASK_END(t) } (t)->lc = 0
+
+//arriving at a wait (rather than resuming at it) means the task got
+//something done this turn
+#define TASK_WAIT_UNTIL(t, cond) \
+    do { (t)->busy = 1; (t)->lc = __LINE__; case __LINE__: if (!(cond)) return; } while (0)
+
+#define TASK_YIELD(t) \
+    do { (t)->busy = 1; (t)->lc = __LINE__; return; case __LINE__: ; } while (0)
+
+#define TASK_SLEEP(t, us) \
+    do { (t)->wake = T0TC + (us); TASK_WAIT_UNTIL(t, taskDue(t)); } while (0)
+
+//has the task's deadline passed (timer 0 wraps, so compare the difference)
+int taskDue(const struct task *t)
+{
+    return (int)(T0TC - t->wake) >= 0;
+}
+
+void inputTask(struct task *t);
+void gameTask(struct task *t);
+void displayTask(struct task *t);
+void soundTask(struct task *t);
+
+struct task tasks[] = {
+    {"input", inputTask},
+    {"game", gameTask},
+    {"display", displayTask},
+    {"sound", soundTask},
+};
+
+#define TASKS ((int)(sizeof(tasks) / sizeof(tasks[0])))
+
+struct task taskIdle = {"idle"};  //turns that found their wait not ready
+unsigned int taskFrames = 0;
+
+//charges a turn to its task or to idle
+RAMFUNC void taskCharge(struct task *t, unsigned int us)
+{
+    if (!t->busy)
+    {
+        t = &taskIdle;
+    }
+    t->frameUs += us;
+    t->totalUs += us;
+}
+
+//closes the books on a frame
+void taskFrame()
+{
+    taskFrames++;
+    for (int i = 0; i <= TASKS; i++)
+    {
+        struct task *t = (i < TASKS) ? &tasks[i] : &taskIdle;
+
+        if (t->frameUs > t->worstUs)
+        {
+            t->worstUs = t->frameUs;
+        }
+        TRACE(TR_TASK, i, (t->frameUs > 0xFFFF) ? 0xFFFF : t->frameUs);
+        t->frameUs = 0;
+    }
+}
+
+//starts the table over, so it covers one game
+void taskClear()
+{
+    taskFrames = 0;
+    for (int i = 0; i <= TASKS; i++)
+    {
+        struct task *t = (i < TASKS) ? &tasks[i] : &taskIdle;
+
+        t->frameUs = 0;
+        t->worstUs = 0;
+        t->totalUs = 0;
+    }
+#ifdef HOST_SIM
+    simBusClear();
+#endif
+}
+
+void taskReport()
+{
+#ifdef HOST_SIM
+    fprintf(stderr, "%-8s %10s %10s %10s\n", "task", "us/frame", "worst us", "total ms");
+    for (int i = 0; i <= TASKS; i++)
+    {
+        struct task *t = (i < TASKS) ? &tasks[i] : &taskIdle;
+
+        fprintf(stderr, "%-8s %10u %10u %10u\n", t->name,
+                taskFrames ? t->totalUs / taskFrames : 0, t->worstUs, t->totalUs / 1000);
+    }
+    simBusReport(taskFrames);
+#endif
+}
+
+//samples the controller every INPUT_US, the game task latches inputVal
+//into game.input at each tick
+void inputTask(struct task *t)
+{
+    TASK_BEGIN(t);
+    while (1)
+    {
+        checkIn();
+        if (!bootTime[BOOT_INTERACTIVE])
+        {
+            bootMark(BOOT_INTERACTIVE);
+        }
+        TASK_SLEEP(t, INPUT_US);
+    }
+    TASK_END(t);
+}
+
+//one tick of each mode
+RAMFUNC void singleMove()
+{
+    gameMove<singleMode>();
+}
+
+RAMFUNC void enduranceMove()
+{
+    gameMove<enduranceMode>();
+}
+
+RAMFUNC void multMove()
+{
+    gameMove<multMode>();
+}
+
+//title screen, then a game every tick until someone is hit
+void gameTask(struct task *t)
+{
+    TASK_BEGIN(t);
+    themeStart();
+    while (1)
+    {
+        //a mode button cuts the theme off and goes straight into a game
+        TASK_WAIT_UNTIL(t, (inputVal == 1) || (inputVal == 2) || (inputVal == MODE_ENDURANCE));
+        themeStop();
+
+        reset();
+        enduranceReset();
+        game.gameMode = inputVal;
+        taskClear();
+        t->wake = T0TC;
+        while (!game.gameOver)
+        {
+            //the display has to be done with the last frame first
+            TASK_WAIT_UNTIL(t, taskDue(t) && !frameReady);
+            t->wake += game.tickMs * 1000;
+            if (taskDue(t))
+            {
+                t->wake = T0TC + game.tickMs * 1000;  //fell a tick behind, don't race to catch up
+            }
+
+            frameBegin();
+            game.input = inputVal;
+            if (game.gameMode == 2)
+            {
+                singleMove();
+            }
+            else if (game.gameMode == MODE_ENDURANCE)
+            {
+                enduranceMove();
+            }
+            else
+            {
+                multMove();
+            }
+        }
+
+        //leave the last frame up for a bit, then back to the title. the
+        //scores go to flash once the hit sound is over, IAP stops the
+        //interrupts (and the audio and display with them) for as long as
+        //a program or an erase takes
+        TASK_WAIT_UNTIL(t, !frameReady);
+        taskReport();
+        TASK_SLEEP(t, GAME_OVER_US);
+        logCommit();
+        displayHome();
+    }
+    TASK_END(t);
+}
+
+//sends finished frames, a page per turn so the other tasks get a look in
+//between
+int flushPage;
+
+void displayTask(struct task *t)
+{
+    TASK_BEGIN(t);
+    while (1)
+    {
+        TASK_WAIT_UNTIL(t, frameReady);
+        captureFrame(output);
+        spiFault = 0;
+        for (flushPage = 0; flushPage < GLCD_PAGES; flushPage++)
+        {
+            display.flush(output + flushPage * GLCD_WIDTH, 0, flushPage, GLCD_WIDTH, 1);
+            TASK_YIELD(t);
+        }
+        if (spiFault)
+        {
+            TRACE(TR_BUSFAULT, 2, busErr.spiTimeouts);
+        }
+
+        frameReady = 0;
+        frameEnd();
+        taskFrame();
+    }
+    TASK_END(t);
+}
+
+//plays queued effects, otherwise the theme while it's on. timer 1 makes
+//the tone, this only starts and stops it
+void soundTask(struct task *t)
+{
+    TASK_BEGIN(t);
+    while (1)
+    {
+        TASK_WAIT_UNTIL(t, (effectTail != effectHead) || (themeNote < 18));
+
+        if (effectTail != effectHead)
+        {
+            effectStart(effectQueue[effectTail & (EFFECT_QUEUE - 1)]);
+#ifndef AUDIO_DAC
+            TASK_SLEEP(t, EFFECT_US);
+            toneStop();
+#endif
+            effectTail++;
+            continue;
+        }
+
+        //themeStop() cuts a note or rest short
+        toneStart(imperialTune[themeNote] * TICK_NS / 1000);
+        t->wake = T0TC + themeNoteLength(themeNote);
+        TASK_WAIT_UNTIL(t, taskDue(t) || (themeNote >= 18));
+        toneStop();
+
+        //rest for a quarter of the note
+        t->wake = T0TC + themeNoteLength(themeNote) / 4;
+        TASK_WAIT_UNTIL(t, taskDue(t) || (themeNote >= 18));
+        if (themeNote < 18)
+        {
+            themeNote++;
+        }
+    }
+    TASK_END(t);
+}
+
+//let the game begin!! runs the tasks in turn forever, timing each turn
+void playGame()
+{
+    unsigned int last = T0TC;
+    unsigned int now;
+
+    while(1) {
+        for (int i = 0; i < TASKS; i++)
+        {
+            tasks[i].busy = 0;
+            tasks[i].run(&tasks[i]);
+            now = T0TC;
+            taskCharge(&tasks[i], now - last);
+            last = now;
+        }
+        traceDrain();
+        busReport(now);
+#if defined(AUDIO_DAC) && defined(HOST_SIM)
+        audioService();
+#endif
+        last = T0TC;
+    }
+}
+
+//main method which deploys initialization functions, puts the title
+//screen up as early as possible, and begins the game!
+int main(void)
+{
+#ifdef HOST_SIM
+    simInit();
+#endif
+
+    //full speed, then timer 0 counting microseconds off the new clock,
+    //everything after is measured against it
+    clockInit();
+    T0PR = TIMER_PRESCALE;
+    T0TCR |= (1<<0);
+#ifdef TRACE_ENABLE
+    traceInit();
+#endif
+    bootMark(BOOT_TIMER);
+
+    //saved scores and settings, before the title shows them or the theme
+    //plays at the saved volume. one pass over a 32kB sector at most, well
+    //under a millisecond, so the title isn't held up
+    logInit();
+    assetsInit();
+
+    //SPI initialization for the subsystem in the LPC1769
+    SPI_init();
+
+    //GLCD initialization, ready for writing
+    GLCD_init();
+    bootMark(BOOT_DISPLAY);
+
+#ifdef BENCH
+    benchRun();
+    stressRun();
+#endif
+
+    displayHome();
+    bootMark(BOOT_TITLE);
+
+    //I2C initialization for the user input, the expander itself is set
+    //up by the first checkIn()
+    I2C_init();
+
+#ifdef AUDIO_DAC
+    audioInit();
+#else
+    //activates P2.0 as output for piezzo (music initialization)
+    PINSEL4 &= ~(1<<1);
+    PINSEL4 &= ~(1<<0);
+    FIO2DIR |= (1<<0);
+#endif
+    bootMark(BOOT_INPUT);
+
+    //let the battle begin!
+    playGame();
+
+    return 0;
+}
@@ -0,0 +1,912 @@
+/*
+===============================================================================
+ Name        : hostsim.c
+ Description : Host (Linux) peripheral models for StarFight.cpp, see
+ hostsim.h. Only built with HOST_SIM defined, so the MCUXpresso project
+ can keep it in the source folder.
+===============================================================================
+*/
+#ifdef HOST_SIM
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hostsim.h"
+
+//addresses the models care about
+#define SIM_FIO0PIN 0x2009c014
+#define SIM_T0TC 0x40004008
+#define SIM_S0SPSR 0x40020004
+#define SIM_U0LSR 0x4000c014
+#define SIM_S0SPCCR 0x4002000c
+#define SIM_I2C0SCLH 0x4001c010
+#define SIM_I2C0SCLL 0x4001c014
+#define SIM_PLL0CON 0x400fc080
+#define SIM_PLL0CFG 0x400fc084
+#define SIM_PLL0STAT 0x400fc088
+#define SIM_CCLKCFG 0x400fc104
+#define SIM_CLKSRCSEL 0x400fc10c
+#define SIM_SCS 0x400fc1a0
+#define SIM_PCLKSEL0 0x400fc1a8
+#define SIM_DWT_CTRL 0xe0001000
+#define SIM_DWT_CYCCNT 0xe0001004
+
+#define SIM_FLASH_SIZE 0x80000
+
+unsigned char simLcd[SIM_LCD_WIDTH * SIM_LCD_PAGES];
+volatile int simButtons = 0;
+
+//**************************************************************************
+//registers
+//
+//a small open addressed table, anything the firmware touches gets a slot
+
+#define SIM_REGS 256
+
+struct simReg
+{
+    unsigned int addr;
+    volatile unsigned int value;
+};
+
+static struct simReg regs[SIM_REGS];
+
+//**************************************************************************
+//clock
+//
+//timer 0 reads a virtual microsecond clock. normally it follows real time
+//and bus transfers sleep for as long as they'd take on the hardware, so
+//the game runs at its real frame rate. in turbo the clock only moves when
+//it's read or the buses are busy, so waits finish at once. transfer times
+//come from the clock tree and dividers the firmware set up
+
+#define TURBO_READ_US 100       //clock advance per read in turbo
+
+static unsigned long long simClock = 0;
+static unsigned long long lastReal = 0;
+static unsigned long long busDebt = 0;   //bus time not slept off yet, ns
+static int turbo = 0;
+
+static unsigned long long realMicros(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static unsigned int simMicros(void)
+{
+    unsigned long long now = realMicros();
+
+    if (turbo)
+    {
+        simClock += TURBO_READ_US;
+    }
+    else
+    {
+        simClock += now - lastReal;
+    }
+    lastReal = now;
+    return (unsigned int)simClock;
+}
+
+//**************************************************************************
+//bus accounting
+//
+//what the bus models carried, the figures the firmware's busReport()
+//works out from its own counters: bytes, transfers, time spent clocking
+//(which the firmware spends polling, so it's its wait time too) and
+//display data bytes that matched what the 5110 already held
+
+#define SIM_SPI 0
+#define SIM_I2C 1
+
+struct busCount
+{
+    unsigned long long bytes;
+    unsigned long long idle;
+    unsigned long long transfers;   //D/C runs on SPI, start to stop on I2C
+    unsigned long long ns;
+};
+
+static struct busCount busCount[2];
+static struct busCount busMark[2];      //the counts at simBusClear()
+static unsigned long long busMarkClock = 0;
+static int spiLastDc = -1;
+
+//time spent on a bus transfer
+static void busTime(int bus, double ns)
+{
+    busCount[bus].ns += (unsigned long long)ns;
+    busDebt += (unsigned long long)ns;
+    if (turbo)
+    {
+        simClock += busDebt / 1000;
+        busDebt %= 1000;
+        return;
+    }
+
+    if (busDebt >= 1000000)
+    {
+        usleep(busDebt / 1000);
+        busDebt = 0;
+    }
+}
+
+//the core clock the PLL0 and divider registers add up to
+static double simCclk(void)
+{
+    double hz = ((*simRegister(SIM_CLKSRCSEL) & 3) == 1) ? 12e6 : 4e6;
+    unsigned int cfg = *simRegister(SIM_PLL0CFG);
+
+    if ((*simRegister(SIM_PLL0CON) & 3) == 3)
+    {
+        hz = 2.0 * ((cfg & 0x7FFF) + 1) * hz / (((cfg >> 16) & 0xFF) + 1);
+    }
+    return hz / ((*simRegister(SIM_CCLKCFG) & 0xFF) + 1);
+}
+
+//peripheral clock for the PCLKSEL0 field at shift
+static double simPclk(int shift)
+{
+    static const int div[4] = {4, 1, 2, 8};
+
+    return simCclk() / div[(*simRegister(SIM_PCLKSEL0) >> shift) & 3];
+}
+
+static double spiByteNs(void)
+{
+    unsigned int div = *simRegister(SIM_S0SPCCR);
+
+    return 8 * ((div < 8) ? 8 : div) * 1e9 / simPclk(16);
+}
+
+//9 clocks with the ack
+static double i2cByteNs(void)
+{
+    unsigned int div = *simRegister(SIM_I2C0SCLH) + *simRegister(SIM_I2C0SCLL);
+
+    return 9 * ((div < 8) ? 8 : div) * 1e9 / simPclk(14);
+}
+
+unsigned int simBusUs(int bus)
+{
+    return (unsigned int)(busCount[bus].ns / 1000);
+}
+
+void simBusClear(void)
+{
+    memcpy(busMark, busCount, sizeof(busMark));
+    busMarkClock = simClock;
+}
+
+void simBusReport(int frames)
+{
+    static const char *name[2] = {"spi", "i2c"};
+    double seconds = (simClock - busMarkClock) / 1e6;
+
+    if ((seconds <= 0) || (frames <= 0))
+    {
+        return;
+    }
+
+    fprintf(stderr, "%-8s %10s %10s %10s %10s %8s\n", "bus", "bytes/s", "bytes/frm",
+            "idle/frm", "xfers/frm", "busy %");
+    for (int bus = 0; bus < 2; bus++)
+    {
+        unsigned long long bytes = busCount[bus].bytes - busMark[bus].bytes;
+
+        fprintf(stderr, "%-8s %10.0f %10.1f %10.1f %10.1f %8.2f\n", name[bus],
+                bytes / seconds, (double)bytes / frames,
+                (double)(busCount[bus].idle - busMark[bus].idle) / frames,
+                (double)(busCount[bus].transfers - busMark[bus].transfers) / frames,
+                (busCount[bus].ns - busMark[bus].ns) / (seconds * 1e7));
+    }
+}
+
+//stops the clock from counting time the sim spent stopped (single step)
+static void clockResync(void)
+{
+    lastReal = realMicros();
+}
+
+volatile unsigned int *simRegister(unsigned int addr)
+{
+    unsigned int i = (addr >> 2) % SIM_REGS;
+
+    while ((regs[i].addr != 0) && (regs[i].addr != addr))
+    {
+        i = (i + 1) % SIM_REGS;
+    }
+    regs[i].addr = addr;
+
+    //status the firmware polls for
+    if (addr == SIM_T0TC)
+    {
+        regs[i].value = simMicros();
+    }
+    else if (addr == SIM_S0SPSR)
+    {
+        regs[i].value = (1<<7);  //SPIF, transfers finish instantly
+    }
+    else if (addr == SIM_U0LSR)
+    {
+        regs[i].value = (1<<5);  //THRE, so is the UART
+    }
+    else if ((addr == SIM_DWT_CYCCNT) && (*simRegister(SIM_DWT_CTRL) & 1))
+    {
+        //core clocks on the sim clock, so only bus time really shows
+        regs[i].value = (unsigned int)(simMicros() * (simCclk() / 1e6));
+    }
+    else if (addr == SIM_SCS)
+    {
+        //the crystal starts as soon as it's enabled
+        regs[i].value = (regs[i].value & ~(1<<6)) | ((regs[i].value & (1<<5)) << 1);
+    }
+    else if (addr == SIM_PLL0STAT)
+    {
+        //enable/connect follow PLL0CON and an enabled PLL is locked
+        unsigned int con = *simRegister(SIM_PLL0CON) & 3;
+
+        regs[i].value = (con << 24) | ((con & 1) << 26);
+    }
+
+    return &regs[i].value;
+}
+
+//**************************************************************************
+//Nokia 5110 (PCD8544) model
+//
+
+static int lcdX = 0;
+static int lcdY = 0;
+static int lcdExtended = 0;  //H bit of the last function set
+
+static void termFrame(void);
+
+void simSpiSend(char data)
+{
+    unsigned char byte = (unsigned char)data;
+    int dc = (*simRegister(SIM_FIO0PIN) >> 7) & 1;
+
+    busTime(SIM_SPI, spiByteNs());
+    busCount[SIM_SPI].bytes++;
+    if (dc != spiLastDc)
+    {
+        busCount[SIM_SPI].transfers++;
+        spiLastDc = dc;
+    }
+
+    if (dc)
+    {
+        if (simLcd[lcdY * SIM_LCD_WIDTH + lcdX] == byte)
+        {
+            busCount[SIM_SPI].idle++;
+        }
+        simLcd[lcdY * SIM_LCD_WIDTH + lcdX] = byte;
+        if (++lcdX == SIM_LCD_WIDTH)
+        {
+            lcdX = 0;
+            lcdY = (lcdY + 1) % SIM_LCD_PAGES;
+
+            //wrapping back to the top is the end of a frame
+            if (lcdY == 0)
+            {
+                termFrame();
+            }
+        }
+        return;
+    }
+
+    if ((byte & 0xF8) == 0x20)
+    {
+        lcdExtended = byte & 1;
+    }
+    else if (!lcdExtended && (byte & 0x80))
+    {
+        lcdX = (byte & 0x7F) % SIM_LCD_WIDTH;
+    }
+    else if (!lcdExtended && ((byte & 0xF8) == 0x40))
+    {
+        lcdY = (byte & 0x07) % SIM_LCD_PAGES;
+    }
+}
+
+//**************************************************************************
+//MCP23017 model, only the register pointer and GPIOA matter
+//
+
+static unsigned char expRegs[0x16];
+static int i2cAddr = -1;   //-1 until the address byte of a transaction
+static int expPointer = 0;
+static int expPointerSet = 0;
+
+static void termKeys(void);
+
+//start and stop take about a bit each
+void simI2cStart(void)
+{
+    busTime(SIM_I2C, i2cByteNs() / 9);
+    busCount[SIM_I2C].transfers++;
+    i2cAddr = -1;
+}
+
+void simI2cWrite(int num)
+{
+    busTime(SIM_I2C, i2cByteNs());
+    busCount[SIM_I2C].bytes++;
+    if (i2cAddr < 0)
+    {
+        i2cAddr = num & 0xFF;
+        expPointerSet = 0;
+        return;
+    }
+    if (i2cAddr != 0x40)
+    {
+        return;
+    }
+    if (!expPointerSet)
+    {
+        expPointer = num % (int)sizeof(expRegs);
+        expPointerSet = 1;
+        return;
+    }
+    expRegs[expPointer] = num & 0xFF;
+    expPointer = (expPointer + 1) % (int)sizeof(expRegs);
+}
+
+int simI2cRead(int ack)
+{
+    int value;
+
+    busTime(SIM_I2C, i2cByteNs());
+    busCount[SIM_I2C].bytes++;
+    if (i2cAddr != 0x41)
+    {
+        return 0xFF;
+    }
+
+    //the controller is sampled when the game reads it
+    if (expPointer == 0x12)
+    {
+        termKeys();
+    }
+    value = (expPointer == 0x12) ? (simButtons & 0xFF) : expRegs[expPointer];
+    expPointer = (expPointer + 1) % (int)sizeof(expRegs);
+    return value;
+}
+
+void simI2cStop(void)
+{
+    busTime(SIM_I2C, i2cByteNs() / 9);
+    i2cAddr = -1;
+}
+
+//**************************************************************************
+//terminal frontend
+//
+//draws simLcd into the terminal with braille cells (2x4 pixels, the
+//default) or half blocks (1x2, SF_CELLS=half), rewriting only the cells
+//that changed since the last frame so it keeps up over ssh. keys press
+//the expander's input bits for a moment, terminal autorepeat keeps them
+//held. SF_HEADLESS=1 (or stdout not being a terminal) turns it off
+//
+//  1 one player    2 two player
+//  w/s  player 1 up/down    d or space  player 1 fire
+//  i/k or arrows  player 2 up/down    j or enter  player 2 fire
+//  t turbo    p pause/single step    n next frame when paused    q quit
+
+#define HOLD_US 120000          //how long a key press holds its button
+#define MAX_CELLS (SIM_LCD_WIDTH * SIM_LCD_PAGES * 8)
+
+static int term = 0;            //frontend active
+static int halfBlocks = 0;
+static int cellsWide, cellsHigh;
+static int prevCell[MAX_CELLS];
+static struct termios savedTermios;
+static unsigned long long held[8];  //clock time each input bit is held to
+static int paused = 0;
+static int stepRequested = 0;
+static unsigned long long frames = 0;
+static unsigned long long statusReal = 0, statusFrames = 0;
+static double fps = 0;
+
+static void termDraw(void);
+
+static int pixel(int x, int y)
+{
+    if ((x >= SIM_LCD_WIDTH) || (y >= SIM_LCD_PAGES * 8))
+    {
+        return 0;
+    }
+    return (simLcd[(y / 8) * SIM_LCD_WIDTH + x] >> (y % 8)) & 1;
+}
+
+//dot pattern of a cell, braille bit order or top/bottom for half blocks
+static int cellBits(int cx, int cy)
+{
+    static const int braille[4][2] = {{0x01, 0x08}, {0x02, 0x10},
+                                      {0x04, 0x20}, {0x40, 0x80}};
+    int bits = 0;
+
+    if (halfBlocks)
+    {
+        return pixel(cx, cy * 2) | (pixel(cx, cy * 2 + 1) << 1);
+    }
+    for (int dy = 0; dy < 4; dy++)
+    {
+        for (int dx = 0; dx < 2; dx++)
+        {
+            if (pixel(cx * 2 + dx, cy * 4 + dy))
+            {
+                bits |= braille[dy][dx];
+            }
+        }
+    }
+    return bits;
+}
+
+//UTF-8 for a cell, returns its length
+static int cellText(int bits, char *out)
+{
+    static const char *half[4] = {" ", "\u2580", "\u2584", "\u2588"};
+
+    if (halfBlocks)
+    {
+        strcpy(out, half[bits]);
+        return (int)strlen(out);
+    }
+    out[0] = (char)0xE2;
+    out[1] = (char)(0xA0 | (bits >> 6));
+    out[2] = (char)(0x80 | (bits & 0x3F));
+    return 3;
+}
+
+static void termWrite(const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(STDOUT_FILENO, buf, len);
+
+        if (n <= 0)
+        {
+            return;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+static void termRestore(void)
+{
+    if (term)
+    {
+        const char *bye = "\033[0m\033[?25h\033[?1049l";
+
+        termWrite(bye, strlen(bye));
+        tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+        term = 0;
+    }
+}
+
+static void termSignal(int sig)
+{
+    termRestore();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void termOpen(void)
+{
+    const char *cells = getenv("SF_CELLS");
+    const char *hello = "\033[?1049h\033[?25l\033[2J";
+    struct termios raw;
+
+    if (getenv("SF_HEADLESS") || !isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO))
+    {
+        return;
+    }
+
+    halfBlocks = cells && !strcmp(cells, "half");
+    cellsWide = halfBlocks ? SIM_LCD_WIDTH : SIM_LCD_WIDTH / 2;
+    cellsHigh = halfBlocks ? SIM_LCD_PAGES * 4 : SIM_LCD_PAGES * 2;
+    for (int i = 0; i < MAX_CELLS; i++)
+    {
+        prevCell[i] = -1;   //forces the first frame to draw everything
+    }
+
+    tcgetattr(STDIN_FILENO, &savedTermios);
+    raw = savedTermios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+    term = 1;
+    atexit(termRestore);
+    signal(SIGINT, termSignal);
+    signal(SIGTERM, termSignal);
+    termWrite(hello, strlen(hello));
+}
+
+static void press(int bit)
+{
+    held[bit] = simClock + HOLD_US;
+}
+
+//reads whatever keys are waiting and works out the held input bits
+static void termKeys(void)
+{
+    unsigned char keys[64];
+    ssize_t n;
+    int buttons = 0;
+
+    if (!term)
+    {
+        return;
+    }
+
+    while ((n = read(STDIN_FILENO, keys, sizeof(keys))) > 0)
+    {
+        for (ssize_t i = 0; i < n; i++)
+        {
+            //arrow keys come in as ESC [ A-D
+            if ((keys[i] == 0x1B) && (i + 2 < n) && (keys[i + 1] == '['))
+            {
+                if (keys[i + 2] == 'A')
+                {
+                    press(4);
+                }
+                else if (keys[i + 2] == 'B')
+                {
+                    press(3);
+                }
+                i += 2;
+                continue;
+            }
+
+            switch (keys[i])
+            {
+                case '1': press(1); break;      //single player (2)
+                case '2': press(0); break;      //multiplayer (1)
+                case 'w': press(7); break;
+                case 's': press(6); break;
+                case 'd': case ' ': press(5); break;
+                case 'i': press(4); break;
+                case 'k': press(3); break;
+                case 'j': case '\r': case '\n': press(2); break;
+                case 't': turbo = !turbo; statusReal = 0; break;
+                case 'p': paused = !paused; statusReal = 0; break;
+                case 'n': case '.': stepRequested = 1; break;
+                case 'q': exit(0);
+            }
+        }
+    }
+
+    for (int bit = 0; bit < 8; bit++)
+    {
+        if (held[bit] > simClock)
+        {
+            buttons |= (1 << bit);
+        }
+    }
+    simButtons = buttons;
+
+    //show a mode change even if the game isn't drawing (title, game over)
+    if (statusReal == 0)
+    {
+        clockResync();
+        termDraw();
+    }
+}
+
+//draws the cells that changed plus a status line
+static void termDraw(void)
+{
+    static char out[MAX_CELLS * 16 + 256];
+    int len = 0, lastX = -2, lastY = -2;
+
+    for (int cy = 0; cy < cellsHigh; cy++)
+    {
+        for (int cx = 0; cx < cellsWide; cx++)
+        {
+            int bits = cellBits(cx, cy);
+
+            if (prevCell[cy * cellsWide + cx] == bits)
+            {
+                continue;
+            }
+            prevCell[cy * cellsWide + cx] = bits;
+
+            //only move the cursor when the change isn't right after the last
+            if ((cy != lastY) || (cx != lastX + 1))
+            {
+                len += sprintf(out + len, "\033[%d;%dH", cy + 1, cx + 1);
+            }
+            len += cellText(bits, out + len);
+            lastX = cx;
+            lastY = cy;
+        }
+    }
+
+    //status about four times a second
+    {
+        unsigned long long now = realMicros();
+
+        if (now - statusReal >= 250000)
+        {
+            fps = (frames - statusFrames) * 1e6 / (double)(now - statusReal);
+            statusReal = now;
+            statusFrames = frames;
+            len += sprintf(out + len, "\033[%d;1H\033[7m %5.0f fps  frame %llu  %s%s \033[0m\033[K",
+                           cellsHigh + 1, fps, frames, turbo ? "TURBO" : "real time",
+                           paused ? "  PAUSED (n steps)" : "");
+        }
+    }
+
+    termWrite(out, len);
+}
+
+//called at the end of every frame the game sends to the 5110
+static void termFrame(void)
+{
+    frames++;
+    if (!term)
+    {
+        return;
+    }
+
+    termDraw();
+
+    //single step, hold here until the next frame is asked for
+    while (paused && !stepRequested && term)
+    {
+        usleep(10000);
+        termKeys();
+    }
+    stepRequested = 0;
+    clockResync();
+}
+
+//**************************************************************************
+//UART0
+//
+
+static FILE *uart;
+
+void simUartSend(unsigned char data)
+{
+    if (uart)
+    {
+        fputc(data, uart);
+    }
+}
+
+//**************************************************************************
+//gameplay capture
+//
+
+static FILE *capture;
+
+void simCapture(const unsigned char *data, int size)
+{
+    if (capture)
+    {
+        fwrite(data, 1, size, capture);
+        fflush(capture);
+    }
+}
+
+//**************************************************************************
+//DAC
+//
+//a plain 16kHz mono WAV, the sizes in its header are brought up to date
+//after every write so the file plays even if the sim is killed
+
+#define SIM_AUDIO_HZ 16000
+
+static FILE *wav;
+static unsigned int wavBytes;
+
+static void wavHeader(void)
+{
+    unsigned char h[44] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                           'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0,
+                           SIM_AUDIO_HZ & 0xFF, SIM_AUDIO_HZ >> 8, 0, 0,
+                           (SIM_AUDIO_HZ * 2) & 0xFF, ((SIM_AUDIO_HZ * 2) >> 8) & 0xFF,
+                           (SIM_AUDIO_HZ * 2) >> 16, 0, 2, 0, 16, 0,
+                           'd', 'a', 't', 'a', 0, 0, 0, 0};
+    unsigned int riff = wavBytes + 36;
+
+    for (int i = 0; i < 4; i++)
+    {
+        h[4 + i] = (riff >> (8 * i)) & 0xFF;
+        h[40 + i] = (wavBytes >> (8 * i)) & 0xFF;
+    }
+    fseek(wav, 0, SEEK_SET);
+    fwrite(h, 1, sizeof(h), wav);
+    fseek(wav, 0, SEEK_END);
+}
+
+void simAudio(const unsigned int *words, int count)
+{
+    if (!wav)
+    {
+        return;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        //10 bit DAC value around 512 to signed 16 bit
+        int sample = ((int)((words[i] >> 6) & 0x3FF) - 512) * 64;
+
+        fputc(sample & 0xFF, wav);
+        fputc((sample >> 8) & 0xFF, wav);
+    }
+    wavBytes += count * 2;
+    wavHeader();
+    fflush(wav);
+}
+
+//**************************************************************************
+//flash
+//
+//the whole part is mapped from a file so the firmware can read it through
+//plain pointers the same way it reads flash on the target
+
+static unsigned char *flash;
+
+static void flashOpen(void)
+{
+    const char *path = getenv("SF_FLASH");
+    int fd;
+
+    if (!path)
+    {
+        path = "starfight.flash";
+    }
+
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        perror(path);
+        exit(1);
+    }
+
+    if (lseek(fd, 0, SEEK_END) != SIM_FLASH_SIZE)
+    {
+        static unsigned char erased[SIM_FLASH_SIZE];
+
+        memset(erased, 0xFF, sizeof(erased));
+        if (pwrite(fd, erased, sizeof(erased), 0) != sizeof(erased))
+        {
+            perror(path);
+            exit(1);
+        }
+    }
+
+    flash = mmap(0, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (flash == MAP_FAILED)
+    {
+        perror(path);
+        exit(1);
+    }
+    close(fd);
+}
+
+const void *simFlash(unsigned int addr)
+{
+    return flash + (addr % SIM_FLASH_SIZE);
+}
+
+//LPC1769 layout: sixteen 4kB sectors then fourteen 32kB ones
+int simFlashErase(int sector)
+{
+    unsigned int addr = (sector < 16) ? sector * 0x1000 :
+                        0x10000 + (sector - 16) * 0x8000;
+    unsigned int size = (sector < 16) ? 0x1000 : 0x8000;
+
+    memset(flash + addr, 0xFF, size);
+    msync(flash, SIM_FLASH_SIZE, MS_SYNC);
+    return 0;
+}
+
+int simFlashProgram(unsigned int addr, const void *src, int size)
+{
+    const unsigned char *bytes = src;
+
+    for (int i = 0; i < size; i++)
+    {
+        flash[addr + i] &= bytes[i];
+    }
+    msync(flash, SIM_FLASH_SIZE, MS_SYNC);
+    return 0;
+}
+
+//**************************************************************************
+//assets
+//
+
+const unsigned char *simAssets(const unsigned char *builtIn)
+{
+    const char *path = getenv("SF_ASSETS");
+    const unsigned char *blob;
+    off_t size;
+    int fd;
+
+    if (!path)
+    {
+        path = "assets.bin";
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return builtIn;
+    }
+    size = lseek(fd, 0, SEEK_END);
+    blob = (size >= 8) ? mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+
+    if ((blob == MAP_FAILED) || memcmp(blob, "SFA1", 4))
+    {
+        fprintf(stderr, "%s: not an asset blob, using the built in art\n", path);
+        return builtIn;
+    }
+    return blob;
+}
+
+//**************************************************************************
+
+void simInit(void)
+{
+    const char *trace = getenv("SF_TRACE");
+    const char *video = getenv("SF_CAPTURE");
+    const char *audio = getenv("SF_AUDIO");
+
+    clockResync();
+    flashOpen();
+    termOpen();
+
+    if (trace)
+    {
+        uart = fopen(trace, "wb");
+        if (!uart)
+        {
+            perror(trace);
+            exit(1);
+        }
+        setvbuf(uart, 0, _IONBF, 0);
+    }
+
+    if (video)
+    {
+        capture = fopen(video, "wb");
+        if (!capture)
+        {
+            perror(video);
+            exit(1);
+        }
+    }
+
+    if (audio)
+    {
+        wav = fopen(audio, "wb");
+        if (!wav)
+        {
+            perror(audio);
+            exit(1);
+        }
+        wavHeader();
+    }
+}
+
+#endif
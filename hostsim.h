@@ -0,0 +1,75 @@
+/*
+===============================================================================
+ Name        : hostsim.h
+ Description : Host (Linux) stand-ins for the LPC1769 peripherals so
+ StarFight.cpp can be built and run on a dev box:
+
+     c++ -DHOST_SIM -o starfight StarFight.cpp -x c hostsim.c
+===============================================================================
+*/
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//the simulated 5110's display RAM, what would be on the glass
+#define SIM_LCD_WIDTH 84
+#define SIM_LCD_PAGES 6
+extern unsigned char simLcd[SIM_LCD_WIDTH * SIM_LCD_PAGES];
+
+//expander input bits the game will read back from GPIOA, driven by the
+//keyboard when the terminal frontend is running
+extern volatile int simButtons;
+
+//also opens the terminal frontend unless stdout isn't a terminal or
+//SF_HEADLESS is set
+void simInit(void);
+
+//storage behind every register address, T0TC reads the sim clock in
+//microseconds (real time, or as fast as it goes in turbo)
+volatile unsigned int *simRegister(unsigned int addr);
+
+//SPI byte out to the 5110 model (D/C comes from FIO0PIN bit 7)
+void simSpiSend(char data);
+
+//I2C transactions against the MCP23017 model
+void simI2cStart(void);
+void simI2cWrite(int num);
+int simI2cRead(int ack);
+void simI2cStop(void);
+
+//the bus models' totals: microseconds each bus (0 SPI, 1 I2C) has spent
+//clocking, and a table of bytes, transfers, idle display bytes and busy
+//time per frame since simBusClear() on stderr
+unsigned int simBusUs(int bus);
+void simBusClear(void);
+void simBusReport(int frames);
+
+//UART0 bytes, appended to the file named by SF_TRACE if it's set
+void simUartSend(unsigned char data);
+
+//gameplay capture bytes (CAPTURE_ENABLE builds), appended to the file
+//named by SF_CAPTURE if it's set
+void simCapture(const unsigned char *data, int size);
+
+//half buffers of DACR words from the AUDIO_DAC mixer, written as 16 bit
+//mono samples at 16kHz to the WAV file named by SF_AUDIO if it's set
+void simAudio(const unsigned int *words, int count);
+
+//the asset blob mmapped from $SF_ASSETS (default assets.bin), or builtIn
+//if there isn't a usable one
+const unsigned char *simAssets(const unsigned char *builtIn);
+
+//file-backed 512kB flash, erased bytes read as 0xFF and programming can
+//only clear bits, like the real thing
+const void *simFlash(unsigned int addr);
+int simFlashErase(int sector);
+int simFlashProgram(unsigned int addr, const void *src, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
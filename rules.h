@@ -0,0 +1,504 @@
+/*
+===============================================================================
+ Name        : rules.h
+ Description : The Star Fight game rules, the one copy of them. The
+ firmware (StarFight.cpp) and the host tools (tools/sfcore.h, so the
+ balancer and the bot environment) both compile this, so a rule changed
+ here changes everywhere. It's plain C that builds as C++ too, and holds:
+
+     the game state block and where everything starts
+     moving the ships and lasers, firing and the wave script interpreter
+     the laser hit and miss tests
+
+ The sprites' art is here too, drawing it, sound, the trace and saved
+ scores stay in the firmware. The includer defines GLCD_WIDTH,
+ GLCD_PAGES, POS() and MID_PAGE first, and after including defines the
+ two hooks declared below the state (the tools' do nothing). RULES_INLINE
+ is how the functions are declared, the firmware makes them forced inline
+ so they end up in its RAM functions. The order things happen in within a
+ tick is the includer's, checked against the tools' by tools/lockstep.cpp
+===============================================================================
+*/
+#ifndef RULES_H
+#define RULES_H
+
+#ifndef RULES_INLINE
+#define RULES_INLINE static inline
+#endif
+
+//game object arrays will hold the following:
+//initial arrayPosition (ie where they should go in output array)
+//width (position will correspond to leftmost bit, so need to know right for bounds
+//height (for the smaller objects that will be moving up by pixels instead of rows
+#define TIE_WIDTH 10              //tieSprite's columns
+#define LASER_WIDTH 3             //laserSprite's
+#define LASER_TIP (LASER_WIDTH - 1)
+#define TIE1_COL 1                //ships' columns, a column in from each edge
+#define TIE2_COL (GLCD_WIDTH - TIE_WIDTH - 1)
+
+#define BALL_START POS(MID_PAGE, (GLCD_WIDTH / 2) + 1)
+#define LASER_START POS(MID_PAGE, GLCD_WIDTH - 2)
+#define TIE1_START POS(MID_PAGE, TIE1_COL)
+#define TIE2_START POS(MID_PAGE, TIE2_COL)
+
+#define FRAME_US 40000            //game tick to start with, one move per tick
+
+//the ships' and lasers' shapes, 8 rows of their width top first, which
+//sprites.h compiles for the firmware and sfcore.h packs for the tools'
+//screens. '#' is solid, 'o' drawn but not solid
+#define TIE_ART \
+    "#........#" \
+    "#........#" \
+    "#..####..#" \
+    "##########" \
+    "##########" \
+    "#..####..#" \
+    "#........#" \
+    "#........#"
+
+#define LASER_ART \
+    "..." \
+    "..." \
+    "..." \
+    "###" \
+    "..." \
+    "..." \
+    "..." \
+    "..."
+
+//everything a game session changes lives in one block, so a reset is a
+//single copy of gameStart (which stays in flash) and a snapshot is just
+//another copy. positions fit a short on every panel and the rest fit a
+//byte, with the shorts first so there's no padding (66 bytes)
+struct gameState
+{
+    short ball[3];
+    short laser1[4];          //fourth laser value is to relay whether it is on or off
+    short laser11[4];
+    short laser2[4];
+    short laser21[4];
+    short tieFighter1[3];
+    short tieFighter2[3];
+    unsigned short score;     //frames survived in the current single player game
+    unsigned short wavePc;    //next wave script instruction
+    unsigned short loopPc;    //where the wave script's LOOP goes back to
+    unsigned short waveSeed;  //wave script RANDOM state, never 0
+    unsigned char gameOver;   //shows whether the game is on or lost
+    unsigned char gameMode;   //inputVal that started the game
+    unsigned char input;      //controller bits the current tick acts on
+    unsigned char wave;       //page the last single player wave was aimed at
+    unsigned char waveWait;   //ticks left on a wave script DELAY
+    unsigned char loops;      //passes left in a wave script REPEAT
+    unsigned char tickMs;     //game tick length, wave scripts speed it up
+    unsigned char difficulty; //KEY_DIFFICULTY when the game started
+};
+
+static const struct gameState gameStart = {
+    {BALL_START, 2, 2},               //ball
+    {LASER_START, LASER_WIDTH, 1, 0}, //laser1
+    {LASER_START, LASER_WIDTH, 1, 0}, //laser11
+    {LASER_START, LASER_WIDTH, 1, 0}, //laser2
+    {LASER_START, LASER_WIDTH, 1, 0}, //laser21
+    {TIE1_START, TIE_WIDTH, 8},       //tieFighter1
+    {TIE2_START, TIE_WIDTH, 8},       //tieFighter2
+    0, 0, 0, 1,                       //score, wavePc, loopPc, waveSeed
+    0, 0, 0, 0,                       //gameOver, gameMode, input, wave
+    0, 0, FRAME_US / 1000, 1          //waveWait, loops, tickMs, difficulty
+};
+
+//hooks the includer defines, for sounds and the trace
+static void rulesShot(int player, int pos);   //fireLaser() put laser 1-4 out at pos
+static void rulesWave(int page, int mask);    //the wave script fired down mask's lanes
+
+//**************************************************************************
+//the object movement functions
+//
+//
+/*
+"shift" moves objects by the pixel on the glcd whereas
+"move" moves objects by the byte
+*/
+
+//moves up 8 pixels
+RULES_INLINE int moveUp(int arrayNum)
+{
+    //makes sure cannot move past upper bounds
+    if (arrayNum >= GLCD_WIDTH)
+    {
+        arrayNum -= GLCD_WIDTH;
+    }
+
+    return arrayNum;
+}
+
+//moves down 8 pixels
+RULES_INLINE int moveDown(int arrayNum)
+{
+    //makes sure cannot move past lower bounds
+    if (arrayNum < POS(GLCD_PAGES - 1, 0))
+    {
+        arrayNum += GLCD_WIDTH;
+    }
+
+    return arrayNum;
+}
+
+//moves right by 1 pixel
+RULES_INLINE int shiftRight(int arrayNum, int width)
+{
+    //takes into account the rightmost pixel using width
+    int arrayNumR = arrayNum + width;
+
+    //makes sure it cannot move onto the next row
+    if((arrayNumR % GLCD_WIDTH) != (GLCD_WIDTH - 1)) {
+        arrayNumR += 1;
+    }
+
+    arrayNum = arrayNumR - width;
+
+    return arrayNum;
+}
+
+//moves left by 1 pixel
+RULES_INLINE int shiftLeft(int arrayNumL)
+{
+    //makes sure it cannot move into the previous row
+    if((arrayNumL % GLCD_WIDTH) != 0) {
+        arrayNumL -= 1;
+    }
+
+    return arrayNumL;
+}
+
+//tie1 movement method
+RULES_INLINE void tie1Move(struct gameState *g, int joy)
+{
+    switch(joy) {
+        case 0:
+            g->tieFighter1[0] = moveUp(g->tieFighter1[0]);
+            break;
+        case 1:
+            g->tieFighter1[0] = moveDown(g->tieFighter1[0]);
+            break;
+    }
+}
+
+//tie2 movement method
+RULES_INLINE void tie2Move(struct gameState *g, int stick)
+{
+    switch(stick) {
+        case 0:
+            g->tieFighter2[0] = moveUp(g->tieFighter2[0]);
+            break;
+        case 1:
+            g->tieFighter2[0] = moveDown(g->tieFighter2[0]);
+            break;
+    }
+}
+
+//triggers at laser button activation, sets current position, and true for laser
+//to appear on the screen
+RULES_INLINE void fireLaser(struct gameState *g, int player)
+{
+    switch(player) {
+        case(1):
+            g->laser1[0] = g->tieFighter1[0] + TIE_WIDTH + 1; //sets laser initial position
+            g->laser1[3] = 1;                   //sets laser as active
+            rulesShot(1, g->laser1[0]);
+            break;
+
+        case(2):
+            g->laser2[0] = g->tieFighter2[0] - LASER_TIP; //sets laser initial position
+            g->laser2[3] = 1;                  //sets laser as true
+            rulesShot(2, g->laser2[0]);
+            break;
+
+        case(3):
+            g->laser11[0] = g->tieFighter1[0] + TIE_WIDTH + 1; //sets laser initial position
+            g->laser11[3] = 1;                  //sets laser as true
+            rulesShot(3, g->laser11[0]);
+            break;
+
+        case(4):
+            g->laser21[0] = g->tieFighter2[0] - LASER_TIP; //sets laser initial position
+            g->laser21[3] = 1;                  //sets laser as true
+            rulesShot(4, g->laser21[0]);
+            break;
+    }
+}
+
+//**************************************************************************
+//controls
+//
+
+//player 1's stick in single player and endurance, only up or down alone
+//counts
+RULES_INLINE void soloInput(struct gameState *g, int input)
+{
+    if (input == 128) {          //up button
+        tie1Move(g, 0);
+    } else if (input == 64) {    //down button
+        tie1Move(g, 1);
+    }
+}
+
+//both players' buttons, every action only counts alongside at most one of
+//the other player's buttons
+RULES_INLINE void multInput(struct gameState *g, int input)
+{
+    if ((input == 128) || (input == (128+16)) ||
+            (input == (128+8)) || (input == (128+4))) {
+        tie1Move(g, 0);
+    } else if ((input == 64) || (input == (64+16)) ||
+            (input == (64+8)) || (input == (64+4))) {
+        tie1Move(g, 1);
+    }
+    if ((input == 32) || (input == (32+16)) ||
+            (input == (32+8)) || (input == (32+4)))
+    {         //fire laser
+        if (g->laser1[3]) {          //fire second laser if first is
+            fireLaser(g, 3);      //active
+        } else {
+            fireLaser(g, 1);
+        }
+    }
+    if ((input == 16) || (input == (128+16)) ||
+            (input == (16+64)) || (input == (16+32)))
+    {
+        tie2Move(g, 0);
+    } else if ((input == 8) || (input == (128+8)) ||
+            (input == (8+64)) || (input == (8+32)))
+    {
+        tie2Move(g, 1);
+    }
+    if ((input == 4) || (input == (4+16)) ||
+            (input == (4+64)) || (input == (4+32)))
+    {         //player 2 lasers
+        if (g->laser2[3])
+        {
+            fireLaser(g, 4);
+        }
+        else
+        {
+            fireLaser(g, 2);
+        }
+    }
+}
+
+//**************************************************************************
+//lasers
+//
+//laser1, laser11, laser2, laser21 is the order everything goes through
+//them in. a rightward laser flies at player 2, the rest at player 1
+
+RULES_INLINE short *laserAt(struct gameState *g, int k)
+{
+    return (k == 0) ? g->laser1 : (k == 1) ? g->laser11 : (k == 2) ? g->laser2 : g->laser21;
+}
+
+//moves a laser that's out on a pixel
+RULES_INLINE void laserMove(short *laser, int rightward)
+{
+    laser[0] = rightward ? shiftRight(laser[0], laser[1]) : shiftLeft(laser[0]);
+}
+
+//the ship a laser has reached (1 or 2) or 0, with its tip in at. lasers
+//that are off still count, as they always have
+RULES_INLINE int laserStrike(const struct gameState *g, const short *laser, int rightward,
+                             int *at)
+{
+    if (rightward)
+    {
+        *at = laser[0] + LASER_TIP;
+        return (*at == g->tieFighter2[0]) ? 2 : 0;
+    }
+    *at = laser[0];
+    return (*at == g->tieFighter1[0] + g->tieFighter1[1]) ? 1 : 0;
+}
+
+//turns a laser off once it's flown past the ship it was fired at and
+//parks it on the other one
+RULES_INLINE void laserPark(const struct gameState *g, short *laser, int rightward)
+{
+    if (rightward)
+    {
+        if (((laser[0] + LASER_TIP) != g->tieFighter2[0]) && (((laser[0] + LASER_TIP) % GLCD_WIDTH) == TIE2_COL))
+        {
+            laser[3] = 0;
+            laser[0] = g->tieFighter1[0];
+        }
+    }
+    else if ((laser[0] != g->tieFighter1[0]) && ((laser[0] % GLCD_WIDTH) == TIE1_COL + TIE_WIDTH))
+    {
+        laser[3] = 0;
+        laser[0] = g->tieFighter2[0];
+    }
+}
+
+//**************************************************************************
+//wave scripts
+//
+//single player waves are a little bytecode, assembled by tools/wavec.c
+//from assets/waves.txt into waves.inc. comeAtMeBro() runs at most
+//WAVE_STEPS instructions a tick and stops early at a DELAY or a FIRE
+//that's waiting on lasers, so a tick costs the same however many patterns
+//the script has. lanes are page masks, bit 0 the top page, and addresses
+//are little endian shorts
+#define OP_END 0                  //stop firing
+#define OP_FIRE 1                 //lanes: fire once there's a free laser for each
+#define OP_AIMED 2                //6 x lanes: FIRE the set for the player's page
+#define OP_DELAY 3                //ticks: wait this many ticks
+#define OP_SPEED 4                //ms: game tick length
+#define OP_RAMP 5                 //ms, floor: tick - ms x difficulty, not below floor
+#define OP_REPEAT 6               //count: run up to the LOOP this many times
+#define OP_LOOP 7
+#define OP_RANDOM 8               //count, count x address: jump to one of them
+#define OP_JUMP 9                 //address
+
+#define WAVE_STEPS 4              //instructions a tick at most
+
+//xorshift on the seed in the game state, so a snapshot replays the same
+//choices
+RULES_INLINE int waveRandom(struct gameState *g)
+{
+    unsigned int x = g->waveSeed;
+
+    x ^= (x << 7) & 0xFFFF;
+    x ^= x >> 9;
+    x ^= (x << 8) & 0xFFFF;
+    g->waveSeed = x;
+    return x;
+}
+
+//an AIMED operand's lanes for the page the player is on, taller panels
+//repeat the six sets down the screen
+RULES_INLINE int waveAim(const unsigned char *sets, int page)
+{
+    int base = page - (page % 6);
+    int mask = 0;
+
+    for (int lane = 0; lane < 6; lane++)
+    {
+        if (sets[page % 6] & (1 << lane))
+        {
+            mask |= 1 << ((base + lane < GLCD_PAGES) ? base + lane : base + lane - 6);
+        }
+    }
+    return mask;
+}
+
+//fires down every lane in mask, 4 columns in from the right edge, or
+//returns 0 if there aren't enough lasers free yet
+RULES_INLINE int waveFire(struct gameState *g, int mask)
+{
+    short *lasers[4] = {g->laser1, g->laser11, g->laser2, g->laser21};
+    int wanted = 0, spare = 0, lane = 0;
+
+    mask &= (1 << GLCD_PAGES) - 1;
+    for (int m = mask; m; m >>= 1)
+    {
+        wanted += m & 1;
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        spare += !lasers[k][3];
+    }
+    if (wanted > spare)
+    {
+        return 0;
+    }
+
+    for (int k = 0; (k < 4) && mask; k++)
+    {
+        if (!lasers[k][3])
+        {
+            while (!(mask & (1 << lane)))
+            {
+                lane++;
+            }
+            lasers[k][0] = POS(lane, GLCD_WIDTH - 4);
+            lasers[k][3] = 1;
+            mask &= ~(1 << lane);
+        }
+    }
+    return 1;
+}
+
+//runs a wave script (waveScript from waves.inc for the game's) for a tick
+//of single player laser dodge
+RULES_INLINE void comeAtMeBro(struct gameState *g, const unsigned char *script)
+{
+    int page = g->tieFighter1[0] / GLCD_WIDTH;
+    int mask, ms;
+
+    if (g->waveWait)
+    {
+        g->waveWait--;
+        return;
+    }
+
+    for (int step = 0; step < WAVE_STEPS; step++)
+    {
+        const unsigned char *op = &script[g->wavePc];
+
+        switch (op[0])
+        {
+            case OP_FIRE:
+            case OP_AIMED:
+                mask = (op[0] == OP_FIRE) ? op[1] : waveAim(op + 1, page);
+                if (!waveFire(g, mask))
+                {
+                    return;
+                }
+                g->wave = page;
+                rulesWave(page, mask);
+                g->wavePc += (op[0] == OP_FIRE) ? 2 : 7;
+                break;
+            case OP_DELAY:
+                g->waveWait = op[1];
+                g->wavePc += 2;
+                return;
+            case OP_SPEED:
+                g->tickMs = op[1];
+                g->wavePc += 2;
+                break;
+            case OP_RAMP:
+                ms = g->tickMs - op[1] * g->difficulty;
+                if (ms < op[2])
+                {
+                    ms = (g->tickMs < op[2]) ? g->tickMs : op[2];
+                }
+                g->tickMs = ms;
+                g->wavePc += 3;
+                break;
+            case OP_REPEAT:
+                g->loops = op[1];
+                g->loopPc = g->wavePc + 2;
+                g->wavePc += 2;
+                break;
+            case OP_LOOP:
+                if (g->loops > 1)
+                {
+                    g->loops--;
+                    g->wavePc = g->loopPc;
+                }
+                else
+                {
+                    g->loops = 0;
+                    g->wavePc += 1;
+                }
+                break;
+            case OP_RANDOM:
+                op += 2 + 2 * (waveRandom(g) % op[1]);
+                g->wavePc = op[0] | (op[1] << 8);
+                break;
+            case OP_JUMP:
+                g->wavePc = op[1] | (op[2] << 8);
+                break;
+            default:                //OP_END, nothing more to fire
+                return;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+===============================================================================
+ Name        : sprites.h
+ Description : Compile-time sprite compiler for StarFight.cpp. Sprites are
+ written as ASCII art and turned by the compiler into everything the game
+ draws and tests with, so it all lands in flash as const data with no
+ setup at run time:
+
+     constexpr auto tieSprite = spriteCompile<10, 8>(
+         "#........#"
+         ...);
+
+ '#' is a solid pixel, 'o' one that's drawn but doesn't collide (engine
+ glow and the like), anything else is empty. Each sprite gets its 5110
+ column bytes (rows of width bytes, bit 0 at the top, like output[]), its
+ collision mask, a left-right mirrored copy for ships facing the other way
+ and the 8 copies moved down 0-7 pixels, each a page taller, so it can be
+ put at any pixel row with plain ORs. The width and height are template
+ parameters, so the blit loops below have constant trip counts and unroll.
+ The blits are RAMINLINE, forced inline into the RAM functions that draw
+ the frame (a plain inline copy left out of line would run from flash)
+===============================================================================
+*/
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#ifndef RAMINLINE
+#define RAMINLINE inline __attribute__((always_inline))
+#endif
+
+template <int W, int H>
+struct Sprite
+{
+    static constexpr int width = W;
+    static constexpr int height = H;
+    static constexpr int pages = (H + 7) / 8;
+    static constexpr int shiftedPages = (H + 14) / 8;
+
+    unsigned char art[pages][W];
+    unsigned char mask[pages][W];                   //the pixels that collide
+    unsigned char mirrored[pages][W];
+    unsigned char shifted[8][shiftedPages][W];      //art moved down 0-7 pixels
+};
+
+//rows of W characters run together into one literal, top row first
+template <int W, int H, int N>
+constexpr Sprite<W, H> spriteCompile(const char (&text)[N])
+{
+    static_assert(N == W * H + 1, "sprite art has to be exactly W x H characters");
+
+    Sprite<W, H> s {};
+
+    for (int y = 0; y < H; y++)
+    {
+        for (int x = 0; x < W; x++)
+        {
+            char c = text[y * W + x];
+            int drawn = (c == '#') || (c == 'o');
+            int solid = (c == '#');
+
+            if (drawn)
+            {
+                s.art[y / 8][x] |= 1 << (y % 8);
+                s.mirrored[y / 8][W - 1 - x] |= 1 << (y % 8);
+            }
+            if (solid)
+            {
+                s.mask[y / 8][x] |= 1 << (y % 8);
+            }
+            for (int shift = 0; shift < 8; shift++)
+            {
+                int row = y + shift;
+
+                if (drawn)
+                {
+                    s.shifted[shift][row / 8][x] |= 1 << (row % 8);
+                }
+            }
+        }
+    }
+    return s;
+}
+
+//stores one page row of a sprite at array position pos, over whatever is
+//there (how the game objects are drawn)
+template <int W>
+RAMINLINE void spritePut(char *buf, int pos, const unsigned char (&cols)[W])
+{
+#pragma GCC unroll 16
+    for (int c = 0; c < W; c++)
+    {
+        buf[pos + c] = cols[c];
+    }
+}
+
+//ORs a sprite into a bufWidth wide frame with its top left pixel at x, y,
+//clipped to the frame
+template <int W, int H>
+RAMINLINE void spriteDraw(char *buf, int bufWidth, int bufPages, int x, int y,
+                       const Sprite<W, H> &s)
+{
+    int page = (y >= 0) ? y / 8 : (y - 7) / 8;
+    int shift = y - page * 8;
+
+    for (int p = 0; p < Sprite<W, H>::shiftedPages; p++)
+    {
+        if ((page + p < 0) || (page + p >= bufPages))
+        {
+            continue;
+        }
+#pragma GCC unroll 16
+        for (int c = 0; c < W; c++)
+        {
+            if ((x + c >= 0) && (x + c < bufWidth))
+            {
+                buf[(page + p) * bufWidth + x + c] |= s.shifted[shift][p][c];
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,402 @@
+/*
+===============================================================================
+ Name        : assetc.c
+ Description : Asset compiler for Star Fight. Reads a list of PBM/PGM
+ images and packs them into one indexed blob in the 5110's page format,
+ written as a binary (for the host simulator to mmap) and/or as a C
+ include (compiled into the firmware's flash).
+
+     cc -O2 -o tools/assetc tools/assetc.c
+     tools/assetc -c assets.inc -o assets.bin assets/assets.txt
+
+ The list has one asset per line, "id NAME image [shifted]", image paths
+ relative to the list. "shifted" adds the 8 vertical pre-shifts so a
+ sprite can be drawn at any pixel row with plain ORs.
+
+ Blob layout, all little endian:
+     "SFA1", u16 count, u16 0
+     count x { u16 id, u8 width, u8 height, u8 format, u8 variants,
+               u16 0, u32 offset }                          (sorted by id)
+     pixel data, each asset 4 byte aligned
+ Format 1 is page format: ceil(height/8) rows of width column bytes, bit 0
+ at the top. A shifted asset has 8 variants of ceil((height+7)/8) rows,
+ variant n moved down n pixels.
+===============================================================================
+*/
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_ASSETS 256
+#define FORMAT_PAGES 1
+
+struct asset
+{
+    int id;
+    char name[64];
+    int width;
+    int height;
+    int variants;
+    unsigned char *pixels;  //width * height, 1 = pixel on
+    unsigned char *data;    //packed page bytes
+    int size;
+    int offset;
+};
+
+static struct asset assets[MAX_ASSETS];
+static int assetCount = 0;
+
+static void fail(const char *what, const char *why)
+{
+    fprintf(stderr, "assetc: %s: %s\n", what, why);
+    exit(1);
+}
+
+//**************************************************************************
+//PBM/PGM reading, plain (P1/P2) and raw (P4/P5)
+//
+
+//next header number, skipping whitespace and comments
+static int pnmNumber(FILE *f, const char *path)
+{
+    int c, n = 0, digits = 0;
+
+    while ((c = fgetc(f)) != EOF)
+    {
+        if (c == '#')
+        {
+            while (((c = fgetc(f)) != EOF) && (c != '\n')) {}
+        }
+        else if (!isspace(c))
+        {
+            break;
+        }
+    }
+    while ((c != EOF) && isdigit(c))
+    {
+        n = n * 10 + (c - '0');
+        digits++;
+        c = fgetc(f);
+    }
+    if (!digits)
+    {
+        fail(path, "bad header");
+    }
+    return n;
+}
+
+//next plain PBM bit, whitespace between bits is optional
+static int pbmBit(FILE *f, const char *path)
+{
+    int c;
+
+    while ((c = fgetc(f)) != EOF)
+    {
+        if (c == '#')
+        {
+            while (((c = fgetc(f)) != EOF) && (c != '\n')) {}
+        }
+        else if ((c == '0') || (c == '1'))
+        {
+            return c - '0';
+        }
+        else if (!isspace(c))
+        {
+            break;
+        }
+    }
+    fail(path, "short or bad raster");
+    return 0;
+}
+
+static void loadImage(struct asset *a, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    int type, maxval = 1;
+
+    if (!f)
+    {
+        fail(path, "can't open");
+    }
+    if ((fgetc(f) != 'P') || ((type = fgetc(f) - '0') < 1) || (type > 5) || (type == 3))
+    {
+        fail(path, "not a PBM or PGM");
+    }
+
+    a->width = pnmNumber(f, path);
+    a->height = pnmNumber(f, path);
+    if ((type == 2) || (type == 5))
+    {
+        maxval = pnmNumber(f, path);
+    }
+    if ((a->width < 1) || (a->width > 255) || (a->height < 1) || (a->height > 255))
+    {
+        fail(path, "images have to be 1-255 pixels each way");
+    }
+    a->pixels = calloc(a->width * a->height, 1);
+
+    //the raw formats have exactly one whitespace byte after the header,
+    //which pnmNumber() already ate
+    for (int y = 0; y < a->height; y++)
+    {
+        unsigned char row[32];  //one P4 row, 255 pixels at most
+
+        if ((type == 4) && (fread(row, 1, (a->width + 7) / 8, f) != (size_t)(a->width + 7) / 8))
+        {
+            fail(path, "short raster");
+        }
+
+        for (int x = 0; x < a->width; x++)
+        {
+            int v;
+
+            switch (type)
+            {
+                case 1:
+                    a->pixels[y * a->width + x] = pbmBit(f, path);
+                    break;
+                case 2:
+                    a->pixels[y * a->width + x] = pnmNumber(f, path) < (maxval + 1) / 2;
+                    break;
+                case 4:
+                    a->pixels[y * a->width + x] = (row[x / 8] >> (7 - (x % 8))) & 1;
+                    break;
+                case 5:
+                    v = fgetc(f);
+                    if (maxval > 255)
+                    {
+                        v = (v << 8) | fgetc(f);
+                    }
+                    if (v < 0)
+                    {
+                        fail(path, "short raster");
+                    }
+                    a->pixels[y * a->width + x] = v < (maxval + 1) / 2;
+                    break;
+            }
+        }
+    }
+    fclose(f);
+}
+
+//**************************************************************************
+//packing
+//
+
+//page format bytes for the image moved down by shift pixels into pages rows
+static void packPages(const struct asset *a, int shift, int pages, unsigned char *out)
+{
+    memset(out, 0, pages * a->width);
+    for (int y = 0; y < a->height; y++)
+    {
+        for (int x = 0; x < a->width; x++)
+        {
+            if (a->pixels[y * a->width + x])
+            {
+                int row = y + shift;
+
+                out[(row / 8) * a->width + x] |= 1 << (row % 8);
+            }
+        }
+    }
+}
+
+static void pack(struct asset *a)
+{
+    if (a->variants == 1)
+    {
+        int pages = (a->height + 7) / 8;
+
+        a->size = pages * a->width;
+        a->data = malloc(a->size);
+        packPages(a, 0, pages, a->data);
+        return;
+    }
+
+    {
+        int pages = (a->height + 14) / 8;
+
+        a->size = 8 * pages * a->width;
+        a->data = malloc(a->size);
+        for (int s = 0; s < 8; s++)
+        {
+            packPages(a, s, pages, a->data + s * pages * a->width);
+        }
+    }
+}
+
+static int byId(const void *l, const void *r)
+{
+    return ((const struct asset *)l)->id - ((const struct asset *)r)->id;
+}
+
+static void put16(unsigned char *p, int v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void put32(unsigned char *p, int v)
+{
+    put16(p, v & 0xFFFF);
+    put16(p + 2, (v >> 16) & 0xFFFF);
+}
+
+//builds the whole blob, returns its size
+static int build(unsigned char **out)
+{
+    int size = 8 + 12 * assetCount;
+    unsigned char *blob;
+
+    qsort(assets, assetCount, sizeof(struct asset), byId);
+    for (int i = 0; i < assetCount; i++)
+    {
+        if ((i > 0) && (assets[i].id == assets[i - 1].id))
+        {
+            fail(assets[i].name, "duplicate id");
+        }
+        pack(&assets[i]);
+        size = (size + 3) & ~3;
+        assets[i].offset = size;
+        size += assets[i].size;
+    }
+
+    blob = calloc(size, 1);
+    memcpy(blob, "SFA1", 4);
+    put16(blob + 4, assetCount);
+    for (int i = 0; i < assetCount; i++)
+    {
+        unsigned char *entry = blob + 8 + 12 * i;
+
+        put16(entry, assets[i].id);
+        entry[2] = assets[i].width;
+        entry[3] = assets[i].height;
+        entry[4] = FORMAT_PAGES;
+        entry[5] = assets[i].variants;
+        put32(entry + 8, assets[i].offset);
+        memcpy(blob + assets[i].offset, assets[i].data, assets[i].size);
+    }
+
+    *out = blob;
+    return size;
+}
+
+//**************************************************************************
+
+static void readList(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[512], dir[512] = "";
+    const char *slash = strrchr(path, '/');
+    int lineNo = 0;
+
+    if (!f)
+    {
+        fail(path, "can't open");
+    }
+    if (slash)
+    {
+        snprintf(dir, sizeof(dir), "%.*s/", (int)(slash - path), path);
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        char image[256], flag[32] = "", full[1024], where[600];
+        struct asset *a = &assets[assetCount];
+        int fields;
+
+        lineNo++;
+        if ((line[strspn(line, " \t")] == '#') || (line[strspn(line, " \t\r\n")] == 0))
+        {
+            continue;
+        }
+
+        snprintf(where, sizeof(where), "%s:%d", path, lineNo);
+        if (assetCount == MAX_ASSETS)
+        {
+            fail(where, "too many assets");
+        }
+        fields = sscanf(line, "%d %63s %255s %31s", &a->id, a->name, image, flag);
+        if ((fields < 3) || (a->id < 1) || (a->id > 0xFFFF))
+        {
+            fail(where, "expected \"id NAME image [shifted]\"");
+        }
+        if ((fields == 4) && strcmp(flag, "shifted"))
+        {
+            fail(where, "the only option is \"shifted\"");
+        }
+        a->variants = (fields == 4) ? 8 : 1;
+
+        snprintf(full, sizeof(full), "%s%s", dir, image);
+        loadImage(a, full);
+        assetCount++;
+    }
+    fclose(f);
+}
+
+static void writeC(const char *path, const char *list, const unsigned char *blob, int size)
+{
+    FILE *f = fopen(path, "w");
+
+    if (!f)
+    {
+        fail(path, "can't write");
+    }
+
+    fprintf(f, "//generated by tools/assetc.c from %s, edit the images instead\n\n", list);
+    for (int i = 0; i < assetCount; i++)
+    {
+        fprintf(f, "#define ASSET_%s %d\n", assets[i].name, assets[i].id);
+    }
+    fprintf(f, "\nconst unsigned char assetBlob[%d] __attribute__((aligned(4))) = {", size);
+    for (int i = 0; i < size; i++)
+    {
+        fprintf(f, "%s0x%02X,", (i % 12) ? " " : "\n    ", blob[i]);
+    }
+    fprintf(f, "\n};\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    const char *binPath = 0, *cPath = 0;
+    unsigned char *blob;
+    int size, opt;
+
+    while ((opt = getopt(argc, argv, "o:c:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o': binPath = optarg; break;
+            case 'c': cPath = optarg; break;
+            default: optind = argc + 1;
+        }
+    }
+    if ((optind != argc - 1) || (!binPath && !cPath))
+    {
+        fprintf(stderr, "usage: %s [-o blob.bin] [-c blob.inc] list.txt\n", argv[0]);
+        return 1;
+    }
+
+    readList(argv[optind]);
+    size = build(&blob);
+
+    if (binPath)
+    {
+        FILE *f = fopen(binPath, "wb");
+
+        if (!f || (fwrite(blob, 1, size, f) != (size_t)size) || fclose(f))
+        {
+            fail(binPath, "can't write");
+        }
+    }
+    if (cPath)
+    {
+        writeC(cPath, argv[optind], blob, size);
+    }
+
+    fprintf(stderr, "%d assets, %d bytes\n", assetCount, size);
+    return 0;
+}
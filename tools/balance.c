@@ -0,0 +1,599 @@
+/*
+===============================================================================
+ Name        : balance.c
+ Description : Monte Carlo balancing runner for the single player laser
+ waves. Plays millions of headless rounds (rules from sfcore.h) of each
+ candidate wave script, the firmware's waveScript and any assembled with
+ tools/wavec -o, at every difficulty setting under scripted and random
+ pilots across every core. Then reports survival-time distributions per
+ script, difficulty and pilot, which pages the player died on, and which
+ of the script's waves can't be dodged at all.
+
+     cc -O2 -pthread -o balance tools/balance.c
+     tools/wavec -o mine.bin mine.txt
+     ./balance -n 400000 -w mine.bin
+
+ -n rounds per script, difficulty and pilot    -w another script (up to 15)
+ -t threads (default all cores)                -f frame cap per round (default 20000)
+ -s seed
+
+ survival times are counted frame by frame up to the cap, so every
+ percentile is exact, at 8 bytes a frame for each candidate, pilot and
+ thread
+===============================================================================
+*/
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sfcore.h"
+
+#define MAX_SCRIPTS 16
+#define DIFFICULTIES 4      //KEY_DIFFICULTY settings tried, 0-3
+#define CHUNK 4096          //rounds per job
+
+//pilots
+#define PILOT_STAY 0        //never touches the stick
+#define PILOT_RANDOM 1      //mashes up/down/nothing uniformly
+#define PILOT_DODGE 2       //heads for the nearest lane with no laser
+#define PILOT_SLOPPY 3      //dodges but fumbles 1 frame in 8
+#define PILOTS 4
+
+static const char *pilotName[PILOTS] = {"stay", "random", "dodge", "sloppy"};
+
+//a wave script to try, the firmware's or one tools/wavec -o assembled
+struct script
+{
+    const char *name;
+    const unsigned char *code;
+    int size;
+};
+
+static struct script scripts[MAX_SCRIPTS];
+static int scriptCount = 1;
+static int candidateCount;  //script c / DIFFICULTIES at difficulty c % DIFFICULTIES
+static long long rounds = 1000000;
+static int frameCap = 20000;
+static unsigned long long seed = 1;
+
+//**************************************************************************
+//random numbers, one generator per job so results don't depend on which
+//worker ran it
+//
+
+static unsigned long long splitmix(unsigned long long *x)
+{
+    unsigned long long z = (*x += 0x9E3779B97F4A7C15ull);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static unsigned int rnd(unsigned long long *x, unsigned int n)
+{
+    return (unsigned int)(((splitmix(x) >> 32) * n) >> 32);
+}
+
+//**************************************************************************
+//pilots
+//
+
+//true when an active laser is coming down this page
+static int laneHot(const struct sfGame *g, int page)
+{
+    for (int k = 0; k < 4; k++)
+    {
+        if (sfLaser(g, k)[3] && ((sfLaser(g, k)[0] / SF_WIDTH) == page))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int dodge(const struct sfGame *g)
+{
+    int page = g->s.tieFighter1[0] / SF_WIDTH;
+
+    if (!laneHot(g, page))
+    {
+        return SF_NONE;
+    }
+    for (int d = 1; d < SF_PAGES; d++)
+    {
+        if ((page - d >= 0) && !laneHot(g, page - d))
+        {
+            return SF_UP;
+        }
+        if ((page + d < SF_PAGES) && !laneHot(g, page + d))
+        {
+            return SF_DOWN;
+        }
+    }
+    return SF_NONE;
+}
+
+static int pilot(int which, const struct sfGame *g, unsigned long long *x)
+{
+    switch (which)
+    {
+        case PILOT_RANDOM:
+            return rnd(x, 3);
+        case PILOT_DODGE:
+            return dodge(g);
+        case PILOT_SLOPPY:
+            return (rnd(x, 8) == 0) ? (int)rnd(x, 3) : dodge(g);
+    }
+    return SF_NONE;
+}
+
+//**************************************************************************
+//work-stealing pool
+//
+//every job is known up front, so each worker's deque is a fixed slice of
+//jobs. the owner takes from the bottom, idle workers steal from the top
+//of someone else's. a worker only writes its own stats
+
+struct job
+{
+    int candidate;
+    int pilot;
+    long long first;        //round number, seeds the job's generator
+    long long count;
+};
+
+struct deque
+{
+    pthread_mutex_t lock;
+    struct job *jobs;
+    int top;
+    int bottom;
+};
+
+struct stats
+{
+    long long rounds;
+    long long frames;
+    long long ms;           //game time survived, the difficulty ramps the tick
+    long long capped;       //still alive at the frame cap
+    long long *hist;        //rounds by frames survived, frameCap + 1 of them
+    long long deathsByPage[SF_PAGES];
+};
+
+struct worker
+{
+    pthread_t thread;
+    int id;
+    struct stats *stats;    //[candidate][pilot], owned by this worker
+};
+
+static struct deque *deques;
+static int workers;
+
+static int popBottom(struct deque *d, struct job *out)
+{
+    int got = 0;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top)
+    {
+        *out = d->jobs[--d->bottom];
+        got = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return got;
+}
+
+static int stealTop(struct deque *d, struct job *out)
+{
+    int got = 0;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top)
+    {
+        *out = d->jobs[d->top++];
+        got = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return got;
+}
+
+static void runJob(const struct job *j, struct stats *st)
+{
+    unsigned long long x = seed ^ ((unsigned long long)j->first << 8) ^
+                           ((unsigned long long)j->candidate << 4) ^ j->pilot;
+    const struct script *sc = &scripts[j->candidate / DIFFICULTIES];
+    struct sfGame g;
+
+    for (long long r = 0; r < j->count; r++)
+    {
+        sfResetScript(&g, sc->code, j->candidate % DIFFICULTIES, (unsigned int)splitmix(&x));
+        while (!g.over && (g.frames < frameCap))
+        {
+            sfStep(&g, pilot(j->pilot, &g, &x));
+            st->ms += g.s.tickMs;
+        }
+
+        st->rounds++;
+        st->frames += g.frames;
+        st->hist[g.frames]++;
+        if (g.over)
+        {
+            st->deathsByPage[g.s.wave]++;
+        }
+        else
+        {
+            st->capped++;
+        }
+    }
+}
+
+static void *workerMain(void *arg)
+{
+    struct worker *w = arg;
+    struct job j;
+
+    w->stats = calloc((size_t)candidateCount * PILOTS, sizeof(struct stats));
+    for (int s = 0; s < candidateCount * PILOTS; s++)
+    {
+        w->stats[s].hist = calloc((size_t)frameCap + 1, sizeof(long long));
+    }
+
+    for (;;)
+    {
+        int found = popBottom(&deques[w->id], &j);
+
+        for (int v = 1; !found && (v < workers); v++)
+        {
+            found = stealTop(&deques[(w->id + v) % workers], &j);
+        }
+        if (!found)
+        {
+            break;      //nothing is ever added, so empty everywhere is done
+        }
+        runJob(&j, &w->stats[j.candidate * PILOTS + j.pilot]);
+    }
+    return 0;
+}
+
+//**************************************************************************
+//unavoidable waves
+//
+//the rules are deterministic once the pilot's inputs are fixed, so a
+//breadth-first search over the pages the player could be on covers every
+//possible input sequence for one wave
+
+//a script that fires nothing, so the search only sees the wave it's given
+static const unsigned char idleScript[1] = {OP_END};
+
+//number of pages the player can finish a wave down mask's lanes on,
+//starting from page, without being hit. 0 means it can't be dodged
+static int escapes(int mask, int page)
+{
+    struct sfGame now[SF_PAGES], next[SF_PAGES];
+    int alive[SF_PAGES] = {0}, nextAlive[SF_PAGES];
+    int count = 0;
+
+    sfResetScript(&now[page], idleScript, 0, 1);
+    now[page].s.tieFighter1[0] = SF_POS(page, TIE1_COL);
+    if (!waveFire(&now[page].s, mask))
+    {
+        return SF_PAGES;        //more lanes than lasers, it never fires
+    }
+    alive[page] = 1;
+
+    for (int frame = 0; frame < SF_WIDTH; frame++)
+    {
+        int done = 1;
+
+        memset(nextAlive, 0, sizeof(nextAlive));
+        for (int p = 0; p < SF_PAGES; p++)
+        {
+            if (!alive[p])
+            {
+                continue;
+            }
+            for (int a = SF_NONE; a <= SF_DOWN; a++)
+            {
+                struct sfGame g = now[p];
+
+                if (!sfStep(&g, a))
+                {
+                    int q = g.s.tieFighter1[0] / SF_WIDTH;
+
+                    next[q] = g;
+                    nextAlive[q] = 1;
+                    for (int k = 0; k < 4; k++)
+                    {
+                        done &= !sfLaser(&g, k)[3];
+                    }
+                }
+            }
+        }
+        memcpy(now, next, sizeof(now));
+        memcpy(alive, nextAlive, sizeof(alive));
+
+        count = 0;
+        for (int p = 0; p < SF_PAGES; p++)
+        {
+            count += alive[p];
+        }
+        if (!count || done)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+//bytes in the instruction at op, see tools/wavec.c
+static int opSize(const unsigned char *op)
+{
+    switch (op[0])
+    {
+        case OP_FIRE:
+        case OP_DELAY:
+        case OP_SPEED:
+        case OP_REPEAT:
+            return 2;
+        case OP_RAMP:
+        case OP_JUMP:
+            return 3;
+        case OP_AIMED:
+            return 7;
+        case OP_RANDOM:
+            return 2 + 2 * op[1];
+    }
+    return 1;                   //END and LOOP
+}
+
+//every wave the script can fire, from every page the player could be on
+//when it goes (FIRE's lanes from anywhere, AIMED's set for that page).
+//prints the ones that can't be dodged as address/page
+static void printUnavoidable(const struct script *sc)
+{
+    int waves = 0, found = 0;
+
+    for (int pc = 0; pc < sc->size; pc += opSize(&sc->code[pc]))
+    {
+        const unsigned char *op = &sc->code[pc];
+
+        if ((op[0] != OP_FIRE) && (op[0] != OP_AIMED))
+        {
+            continue;
+        }
+        waves++;
+        for (int page = 0; page < SF_PAGES; page++)
+        {
+            if (!escapes((op[0] == OP_FIRE) ? op[1] : waveAim(op + 1, page), page))
+            {
+                printf(" %04X/%d", pc, page);
+                found++;
+            }
+        }
+    }
+    printf(found ? "   (of %d waves)\n" : " none of %d waves\n", waves);
+}
+
+//**************************************************************************
+//reporting
+//
+
+static long long percentile(const struct stats *st, double q)
+{
+    long long want = (long long)(q * st->rounds), seen = 0;
+
+    for (int f = 0; f <= frameCap; f++)
+    {
+        seen += st->hist[f];
+        if (seen > want)
+        {
+            return f;
+        }
+    }
+    return frameCap;
+}
+
+static void report(struct worker *w)
+{
+    printf("%-6s %-4s %-7s %10s %9s %8s %7s %7s %7s %7s %7s  deaths by page\n",
+           "script", "diff", "pilot", "rounds", "mean", "mean s", "p10", "p50", "p90", "p99",
+           "capped");
+
+    for (int c = 0; c < candidateCount; c++)
+    {
+        for (int pl = 0; pl < PILOTS; pl++)
+        {
+            struct stats sum;
+
+            memset(&sum, 0, sizeof(sum));
+            sum.hist = calloc((size_t)frameCap + 1, sizeof(long long));
+            for (int i = 0; i < workers; i++)
+            {
+                const struct stats *st = &w[i].stats[c * PILOTS + pl];
+
+                sum.rounds += st->rounds;
+                sum.frames += st->frames;
+                sum.ms += st->ms;
+                sum.capped += st->capped;
+                for (int f = 0; f <= frameCap; f++)
+                {
+                    sum.hist[f] += st->hist[f];
+                }
+                for (int p = 0; p < SF_PAGES; p++)
+                {
+                    sum.deathsByPage[p] += st->deathsByPage[p];
+                }
+            }
+
+            printf("%-6d %-4d %-7s %10lld %9.1f %8.1f %7lld %7lld %7lld %7lld %6.2f%% ",
+                   c / DIFFICULTIES, c % DIFFICULTIES, pilotName[pl], sum.rounds,
+                   sum.rounds ? (double)sum.frames / sum.rounds : 0.0,
+                   sum.rounds ? sum.ms / 1000.0 / sum.rounds : 0.0,
+                   percentile(&sum, 0.10), percentile(&sum, 0.50),
+                   percentile(&sum, 0.90), percentile(&sum, 0.99),
+                   sum.rounds ? 100.0 * sum.capped / sum.rounds : 0.0);
+            for (int p = 0; p < SF_PAGES; p++)
+            {
+                printf(" %lld", sum.deathsByPage[p]);
+            }
+            printf("\n");
+            free(sum.hist);
+        }
+    }
+
+    printf("\nscript  bytes  unavoidable waves (address/player page)\n");
+    for (int s = 0; s < scriptCount; s++)
+    {
+        printf("%-6d %6d ", s, scripts[s].size);
+        printUnavoidable(&scripts[s]);
+        printf("        %s\n", scripts[s].name);
+    }
+}
+
+//**************************************************************************
+
+//reads a script tools/wavec -o wrote, 0 if it can't
+static int loadScript(struct script *sc, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    unsigned char *code = malloc(0x10000);
+    int size;
+
+    if (!f || !code)
+    {
+        perror(path);
+        return 0;
+    }
+    size = (int)fread(code, 1, 0x10000, f);
+    fclose(f);
+    if (size < 1)
+    {
+        fprintf(stderr, "%s: empty script\n", path);
+        return 0;
+    }
+    sc->name = path;
+    sc->code = code;
+    sc->size = size;
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    long long jobCount, next = 0;
+    struct worker *w;
+    struct job *jobs;
+    struct timespec t0, t1;
+    double secs;
+
+    workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    //script 0 is the one the firmware plays
+    scripts[0].name = "waveScript (waves.inc)";
+    scripts[0].code = waveScript;
+    scripts[0].size = (int)sizeof(waveScript);
+
+    while ((opt = getopt(argc, argv, "n:w:t:f:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': rounds = atoll(optarg); break;
+            case 'w':
+                if ((scriptCount == MAX_SCRIPTS) || !loadScript(&scripts[scriptCount++], optarg))
+                {
+                    fprintf(stderr, "%s: can't use script %s\n", argv[0], optarg);
+                    return 1;
+                }
+                break;
+            case 't': workers = atoi(optarg); break;
+            case 'f': frameCap = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, 0, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n rounds] [-w script.bin] [-t threads]"
+                        " [-f frame cap] [-s seed]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((workers < 1) || (rounds < 1) || (frameCap < 1))
+    {
+        fprintf(stderr, "%s: bad arguments\n", argv[0]);
+        return 1;
+    }
+
+    candidateCount = scriptCount * DIFFICULTIES;
+
+    //cut the work into jobs and deal them out round robin
+    jobCount = (long long)candidateCount * PILOTS * ((rounds + CHUNK - 1) / CHUNK);
+    jobs = malloc(jobCount * sizeof(struct job));
+    deques = calloc(workers, sizeof(struct deque));
+    w = calloc(workers, sizeof(struct worker));
+
+    for (int c = 0; c < candidateCount; c++)
+    {
+        for (int pl = 0; pl < PILOTS; pl++)
+        {
+            for (long long r = 0; r < rounds; r += CHUNK)
+            {
+                jobs[next].candidate = c;
+                jobs[next].pilot = pl;
+                jobs[next].first = r;
+                jobs[next].count = (rounds - r < CHUNK) ? rounds - r : CHUNK;
+                next++;
+            }
+        }
+    }
+
+    //each deque gets a contiguous run of the (interleaved) job list
+    {
+        struct job *dealt = malloc(jobCount * sizeof(struct job));
+        long long at = 0;
+
+        for (int i = 0; i < workers; i++)
+        {
+            pthread_mutex_init(&deques[i].lock, 0);
+            deques[i].jobs = dealt + at;
+            for (long long j = i; j < jobCount; j += workers)
+            {
+                dealt[at++] = jobs[j];
+            }
+            deques[i].bottom = (int)(dealt + at - deques[i].jobs);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < workers; i++)
+    {
+        w[i].id = i;
+        pthread_create(&w[i].thread, 0, workerMain, &w[i]);
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        pthread_join(w[i].thread, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    report(w);
+
+    {
+        long long totalRounds = 0, totalFrames = 0;
+
+        for (int i = 0; i < workers; i++)
+        {
+            for (int s = 0; s < candidateCount * PILOTS; s++)
+            {
+                totalRounds += w[i].stats[s].rounds;
+                totalFrames += w[i].stats[s].frames;
+            }
+        }
+        printf("\n%lld rounds, %lld frames in %.2fs on %d threads"
+               " (%.0f rounds/s, %.0f frames/s)\n", totalRounds, totalFrames,
+               secs, workers, totalRounds / secs, totalFrames / secs);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*
+===============================================================================
+ Name        : envbench.c
+ Description : Throughput check for the sfenv.h environments. Every thread
+ drives its own environment of N games with random controller bytes and
+ the totals are reported as game steps per second, for both modes with and
+ without the screens drawn.
+
+     cc -O2 -pthread -o envbench tools/envbench.c tools/sfenv.c
+     ./envbench -n 256 -s 20000
+
+ -n games per environment (default 256)   -s steps per thread (default 20000)
+ -t threads (default all cores)           -f frame cap (default 20000)
+===============================================================================
+*/
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sfenv.h"
+
+static int games = 256;
+static int steps = 20000;
+static int frameCap = 20000;
+
+struct worker
+{
+    pthread_t thread;
+    int mode;
+    int render;
+    unsigned int seed;
+    long long finished;         //games that ended
+    int failed;
+};
+
+//xorshift32, one per worker
+static unsigned int rnd(unsigned int *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+static void *workerMain(void *arg)
+{
+    //buttons a pilot can hold, mostly the ones the game reacts to
+    static const unsigned char buttons[8] = {0, SF_P1_UP, SF_P1_DOWN, SF_P1_FIRE,
+                                             SF_P2_UP, SF_P2_DOWN, SF_P2_FIRE,
+                                             SF_P1_FIRE | SF_P2_FIRE};
+    struct worker *w = arg;
+    struct sfEnv *env = sfEnvCreate(games, w->mode, frameCap, w->render);
+    struct sfObs *obs = malloc(games * sizeof(struct sfObs));
+    unsigned char *actions = malloc(games);
+    unsigned char *done = malloc(games);
+    float *reward = malloc(games * sizeof(float));
+
+    if (!env || !obs || !actions || !done || !reward)
+    {
+        w->failed = 1;
+        return 0;
+    }
+
+    sfEnvReset(env, games, obs);
+    for (int s = 0; s < steps; s++)
+    {
+        for (int i = 0; i < games; i++)
+        {
+            actions[i] = buttons[rnd(&w->seed) & 7];
+        }
+        sfEnvStep(env, actions, obs, reward, done);
+        for (int i = 0; i < games; i++)
+        {
+            w->finished += (done[i] != 0);
+        }
+    }
+
+    sfEnvDestroy(env);
+    free(obs);
+    free(actions);
+    free(done);
+    free(reward);
+    return 0;
+}
+
+static int run(int workers, int mode, int render)
+{
+    struct worker *w = calloc(workers, sizeof(struct worker));
+    struct timespec t0, t1;
+    long long finished = 0;
+    double secs, total;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < workers; i++)
+    {
+        w[i].mode = mode;
+        w[i].render = render;
+        w[i].seed = 2463534242u + 7919u * i;
+        pthread_create(&w[i].thread, 0, workerMain, &w[i]);
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        pthread_join(w[i].thread, 0);
+        if (w[i].failed)
+        {
+            fprintf(stderr, "couldn't create an environment of %d games\n", games);
+            free(w);
+            return -1;
+        }
+        finished += w[i].finished;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    total = (double)workers * games * steps;
+
+    printf("%-6s %-9s %12.0f steps/s %10.1f ns/step/thread %10lld games ended\n",
+           (mode == SFENV_SINGLE) ? "single" : "multi", render ? "render" : "no render",
+           total / secs, secs * 1e9 * workers / total, finished);
+    free(w);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:t:f:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': games = atoi(optarg); break;
+            case 's': steps = atoi(optarg); break;
+            case 't': workers = atoi(optarg); break;
+            case 'f': frameCap = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n games] [-s steps] [-t threads] [-f cap]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if ((games < 1) || (steps < 1) || (workers < 1))
+    {
+        fprintf(stderr, "games, steps and threads have to be positive\n");
+        return 1;
+    }
+
+    printf("%d threads x %d games x %d steps, %zu byte observations\n\n",
+           workers, games, steps, sizeof(struct sfObs));
+    for (int mode = 0; mode < 2; mode++)
+    {
+        for (int render = 0; render < 2; render++)
+        {
+            if (run(workers, mode ? SFENV_MULTI : SFENV_SINGLE, render))
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*
+===============================================================================
+ Name        : lockstep.cpp
+ Description : Plays the firmware (built for the host simulator) and
+ sfcore.h side by side with the same inputs and compares the whole game
+ state every frame, so the order the tools run the shared rules in can't
+ drift from gameMove<>()'s. Multiplayer games get random controller bytes,
+ including the button combinations that don't count, and single player
+ games run the wave script at every difficulty under a random and a
+ dodging pilot. The tools' sprite columns are checked against the
+ firmware's first. Exits 1 at the first thing that differs.
+
+     c++ -DHOST_SIM -o lockstep tools/lockstep.cpp -x c hostsim.c
+     SF_HEADLESS=1 SF_FLASH=/tmp/lockstep.flash ./lockstep -n 1000
+
+ -n games of each mode (default 1000)   -f frame cap (default 20000)
+===============================================================================
+*/
+#define main starFightMain
+#include "../StarFight.cpp"
+#undef main
+
+#define SFCORE_FIRMWARE
+#include "sfcore.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int frameCap = 20000;
+
+//controller bytes for multiplayer, every single button, the pairs that
+//count and a few that don't
+static const unsigned char multBytes[] = {0, 128, 64, 32, 16, 8, 4, 128+16, 128+8,
+                                          128+4, 64+16, 64+8, 64+4, 32+16, 32+8,
+                                          32+4, 128+32, 64+32, 8+4, 255};
+
+static unsigned int xorshift(unsigned int *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+//heads for the nearest page no laser is out on, like balance.c's dodge
+static int dodge(const struct gameState *s)
+{
+    int page = s->tieFighter1[0] / GLCD_WIDTH;
+    int busy[GLCD_PAGES] = {0};
+
+    for (int k = 0; k < 4; k++)
+    {
+        if (laserAt((struct gameState *)s, k)[3])
+        {
+            busy[laserAt((struct gameState *)s, k)[0] / GLCD_WIDTH] = 1;
+        }
+    }
+    for (int d = 0; d < GLCD_PAGES; d++)
+    {
+        if ((page - d >= 0) && !busy[page - d])
+        {
+            return d ? SF_P1_UP : 0;
+        }
+        if ((page + d < GLCD_PAGES) && !busy[page + d])
+        {
+            return SF_P1_DOWN;
+        }
+    }
+    return 0;
+}
+
+//the firmware's game against sfcore's, the fields only the firmware keeps
+//(gameOver, gameMode, input) aside. prints both and returns 0 if they differ
+static int same(const struct sfGame *g, int end, const char *mode, int round, int frame)
+{
+    struct gameState fw = game;
+
+    fw.gameOver = fw.gameMode = fw.input = 0;
+    if ((memcmp(&fw, &g->s, sizeof(fw)) == 0) && ((end != 0) == (game.gameOver != 0)))
+    {
+        return 1;
+    }
+
+    printf("%s game %d differs at frame %d (sfcore %s, firmware %s)\n", mode, round, frame,
+           end ? "over" : "on", game.gameOver ? "over" : "on");
+    printf("          tie1 tie2  laser1   laser11  laser2   laser21  score pc  seed tick\n");
+    for (int side = 0; side < 2; side++)
+    {
+        const struct gameState *s = side ? &fw : &g->s;
+
+        printf("%-9s %4d %4d", side ? "firmware" : "sfcore", s->tieFighter1[0], s->tieFighter2[0]);
+        for (int k = 0; k < 4; k++)
+        {
+            printf("  %4d/%d ", laserAt((struct gameState *)s, k)[0],
+                   laserAt((struct gameState *)s, k)[3]);
+        }
+        printf(" %5d %3d %5d %3d\n", s->score, s->wavePc, s->waveSeed, s->tickMs);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = 1000, opt;
+    unsigned int x = 12345;
+    long long frames[2] = {0, 0};
+
+    while ((opt = getopt(argc, argv, "n:f:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': rounds = atoi(optarg); break;
+            case 'f': frameCap = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n games] [-f frame cap]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    simInit();
+    assetsInit();
+
+    {
+        unsigned char tie[2][TIE_WIDTH], laser[LASER_WIDTH];
+
+        sfArt(tie[0], TIE_ART, TIE_WIDTH, 0);
+        sfArt(tie[1], TIE_ART, TIE_WIDTH, 1);
+        sfArt(laser, LASER_ART, LASER_WIDTH, 0);
+        if (memcmp(tie[0], tieSprite.art[0], TIE_WIDTH) ||
+                memcmp(tie[1], tieSprite.mirrored[0], TIE_WIDTH) ||
+                memcmp(laser, laserSprite.art[0], LASER_WIDTH))
+        {
+            printf("sfArt() doesn't draw the sprites the way spriteCompile() does\n");
+            return 1;
+        }
+    }
+
+    for (int r = 0; r < rounds; r++)
+    {
+        struct sfGame g;
+        int end = 0;
+
+        sfReset(&g);
+        reset();
+        game.gameMode = 1;
+        game.difficulty = g.s.difficulty;
+        game.waveSeed = g.s.waveSeed;
+        for (int f = 0; (f < frameCap) && !end; f++)
+        {
+            game.input = multBytes[xorshift(&x) % sizeof(multBytes)];
+            gameMove<multMode>();
+            end = sfMultStep(&g, game.input);
+            frames[0]++;
+            if (!same(&g, end, "multiplayer", r, f))
+            {
+                return 1;
+            }
+        }
+    }
+
+    for (int r = 0; r < rounds; r++)
+    {
+        struct sfGame g;
+        int end = 0, hold = 0, input = 0;
+
+        sfResetScript(&g, waveScript, r % 4, r * 7919 + 3);
+        reset();
+        game.gameMode = 2;
+        game.difficulty = g.s.difficulty;
+        game.waveSeed = g.s.waveSeed;
+        for (int f = 0; (f < frameCap) && !end; f++)
+        {
+            //odd games dodge, even ones hold a random stick for a few frames
+            if (r & 1)
+            {
+                input = dodge(&game);
+            }
+            else if (!hold--)
+            {
+                static const int stick[3] = {0, SF_P1_UP, SF_P1_DOWN};
+
+                input = stick[xorshift(&x) % 3];
+                hold = xorshift(&x) % 6;
+            }
+            game.input = input;
+            gameMove<singleMode>();
+            end = sfStep(&g, (input == SF_P1_UP) ? SF_UP : (input == SF_P1_DOWN) ? SF_DOWN : SF_NONE);
+            frames[1]++;
+            if (!same(&g, end, "single player", r, f))
+            {
+                return 1;
+            }
+        }
+    }
+
+    printf("%d multiplayer games (%lld frames) and %d single player (%lld frames) match\n",
+           rounds, frames[0], rounds, frames[1]);
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+===============================================================================
+ Name        : sfcore.h
+ Description : The game rules for the host tools, single player (the wave
+ script, singleMode) and multiplayer (multMode) through the same laser
+ pipeline as gameMove<>(), with all of a game's state in one struct, so
+ any number of games can run side by side without sharing anything. The
+ rules themselves are ../rules.h, the same code the firmware builds, so
+ all that's here is the order a tick runs them in. tools/lockstep.cpp
+ plays the firmware and this against each other frame by frame:
+
+     c++ -DHOST_SIM -o lockstep tools/lockstep.cpp -x c hostsim.c
+===============================================================================
+*/
+#ifndef SFCORE_H
+#define SFCORE_H
+
+//5110 geometry, same meaning as in StarFight.cpp (which has already set
+//them when it's built in alongside)
+#ifndef GLCD_WIDTH
+#define GLCD_WIDTH 84
+#define GLCD_PAGES 6
+#define POS(page, col) ((page) * GLCD_WIDTH + (col))
+#define MID_PAGE ((GLCD_PAGES / 2) - 1)
+#endif
+
+#define SF_WIDTH GLCD_WIDTH
+#define SF_PAGES GLCD_PAGES
+#define SF_POS(page, col) POS(page, col)
+
+#include "../rules.h"
+
+//the firmware's sounds and trace, nothing for the tools. lockstep.cpp
+//sets SFCORE_FIRMWARE and uses StarFight.cpp's
+#ifndef SFCORE_FIRMWARE
+static void rulesShot(int player, int pos)
+{
+    (void)player;
+    (void)pos;
+}
+
+static void rulesWave(int page, int mask)
+{
+    (void)page;
+    (void)mask;
+}
+#endif
+
+//the page of column bytes the update functions store for a sprite, made
+//from its rules.h art the way sprites.h's spriteCompile() makes art[0]
+//(or mirrored[0], for player 2's ship)
+static inline void sfArt(unsigned char *cols, const char *art, int width, int mirrored)
+{
+    for (int x = 0; x < width; x++)
+    {
+        int col = mirrored ? width - 1 - x : x;
+
+        cols[col] = 0;
+        for (int y = 0; y < 8; y++)
+        {
+            if ((art[y * width + x] == '#') || (art[y * width + x] == 'o'))
+            {
+                cols[col] |= 1 << y;
+            }
+        }
+    }
+}
+
+//player actions for a frame
+#define SF_NONE 0
+#define SF_UP 1
+#define SF_DOWN 2
+
+//the firmware's wave script (static const unsigned char waveScript[])
+#include "../waves.inc"
+
+//controller bits (inputVal) for sfMultStep()
+#define SF_P1_UP 128
+#define SF_P1_DOWN 64
+#define SF_P1_FIRE 32
+#define SF_P2_UP 16
+#define SF_P2_DOWN 8
+#define SF_P2_FIRE 4
+
+struct sfGame
+{
+    struct gameState s;             //the firmware's game, see rules.h
+    const unsigned char *script;    //wave script single player plays
+    int frames;         //frames survived
+    int over;           //1 when hit, or the winning player in multiplayer
+};
+
+//laser1, laser11, laser2, laser21 by number
+static inline const short *sfLaser(const struct sfGame *g, int k)
+{
+    return laserAt((struct gameState *)&g->s, k);
+}
+
+//a game of the firmware's script at its default settings
+static inline void sfReset(struct sfGame *g)
+{
+    g->s = gameStart;
+    g->script = waveScript;
+    g->frames = 0;
+    g->over = 0;
+}
+
+//a game that plays a wave script (waveScript for the firmware's) at a
+//KEY_DIFFICULTY setting, seed picks its random choices
+static inline void sfResetScript(struct sfGame *g, const unsigned char *script,
+                                 int difficulty, unsigned int seed)
+{
+    sfReset(g);
+    g->script = script;
+    g->s.difficulty = difficulty;
+    g->s.waveSeed = (seed & 0xFFFF) | 1;
+}
+
+//updateGame<>() and gameOver<>() for the lasers: the first rightward of
+//laser1, laser11, laser2, laser21 fly right at player 2 and the rest left
+//at player 1. returns the ship hit (1 or 2), or parks the ones that
+//missed and returns 0
+static inline int sfLasers(struct sfGame *g, int rightward)
+{
+    int at, ship;
+
+    for (int k = 0; k < 4; k++)
+    {
+        if (laserAt(&g->s, k)[3] == 1)
+        {
+            laserMove(laserAt(&g->s, k), k < rightward);
+        }
+    }
+
+    for (int k = 0; k < 4; k++)
+    {
+        ship = laserStrike(&g->s, laserAt(&g->s, k), k < rightward, &at);
+        if (ship)
+        {
+            return ship;
+        }
+    }
+
+    for (int k = 0; k < 4; k++)
+    {
+        laserPark(&g->s, laserAt(&g->s, k), k < rightward);
+    }
+    return 0;
+}
+
+//one pass of the single player loop, returns 1 on the frame the player
+//is hit
+static inline int sfStep(struct sfGame *g, int action)
+{
+    struct gameState *s = &g->s;
+
+    g->frames++;
+    if (s->score < 0xFFFF)
+    {
+        s->score++;
+    }
+
+    //singleMode::tick()
+    comeAtMeBro(s, g->script);
+    soloInput(s, (action == SF_UP) ? SF_P1_UP : (action == SF_DOWN) ? SF_P1_DOWN : 0);
+
+    if (sfLasers(g, 0))
+    {
+        g->over = 1;
+        return 1;
+    }
+    return 0;
+}
+
+//one pass of the multiplayer loop with a controller sample, returns the
+//winning player (1 or 2) on the frame someone is hit
+static inline int sfMultStep(struct sfGame *g, int input)
+{
+    g->frames++;
+
+    //multMode::tick(), player 1's lasers fly right
+    multInput(&g->s, input);
+
+    //the winner is whoever wasn't hit
+    g->over = sfLasers(g, 2);
+    if (g->over)
+    {
+        g->over = 3 - g->over;
+        return g->over;
+    }
+    return 0;
+}
+
+#endif
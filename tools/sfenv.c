@@ -0,0 +1,156 @@
+/*
+===============================================================================
+ Name        : sfenv.c
+ Description : The vectorized environment in sfenv.h. Games step straight
+ through sfcore.h's rules and the screens are drawn with its copies of the
+ firmware's sprites, in the order the update functions draw them.
+===============================================================================
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "sfenv.h"
+
+//the firmware's default KEY_DIFFICULTY
+#define SFENV_DIFFICULTY 1
+
+struct sfEnv
+{
+    int capacity;
+    int n;                      //games running
+    int mode;
+    int frameCap;
+    int render;
+    unsigned char tieArt[2][TIE_WIDTH];     //player 1's ship and player 2's
+    unsigned char laserArt[LASER_WIDTH];
+    struct sfGame games[];
+};
+
+struct sfEnv *sfEnvCreate(int capacity, int mode, int frameCap, int render)
+{
+    struct sfEnv *env;
+
+    if ((capacity < 1) || ((mode != SFENV_SINGLE) && (mode != SFENV_MULTI)))
+    {
+        return 0;
+    }
+
+    env = malloc(sizeof(*env) + (size_t)capacity * sizeof(struct sfGame));
+    if (!env)
+    {
+        return 0;
+    }
+    env->capacity = capacity;
+    env->n = 0;
+    env->mode = mode;
+    env->frameCap = frameCap;
+    env->render = render;
+    sfArt(env->tieArt[0], TIE_ART, TIE_WIDTH, 0);
+    sfArt(env->tieArt[1], TIE_ART, TIE_WIDTH, 1);
+    sfArt(env->laserArt, LASER_ART, LASER_WIDTH, 0);
+    return env;
+}
+
+void sfEnvDestroy(struct sfEnv *env)
+{
+    free(env);
+}
+
+//sprites are stored over whatever is under them, like output[] is
+static void blit(unsigned char *screen, int pos, const unsigned char *art, int width)
+{
+    for (int c = 0; (c < width) && (pos + c < SF_WIDTH * SF_PAGES); c++)
+    {
+        screen[pos + c] = art[c];
+    }
+}
+
+static void observe(const struct sfEnv *env, const struct sfGame *g, struct sfObs *o)
+{
+    o->tie[0] = g->s.tieFighter1[0];
+    o->tie[1] = g->s.tieFighter2[0];
+    for (int k = 0; k < 4; k++)
+    {
+        o->laser[k] = sfLaser(g, k)[0];
+        o->on[k] = (unsigned char)sfLaser(g, k)[3];
+    }
+    o->frames = (unsigned int)g->frames;
+    o->wave = g->s.wave;
+
+    if (!env->render)
+    {
+        return;
+    }
+
+    memset(o->screen, 0, sizeof(o->screen));
+    blit(o->screen, g->s.tieFighter1[0], env->tieArt[0], TIE_WIDTH);
+    if (env->mode == SFENV_MULTI)
+    {
+        blit(o->screen, g->s.tieFighter2[0], env->tieArt[1], TIE_WIDTH);
+    }
+    //lasers in updateGame<>() order
+    for (int k = 0; k < 4; k++)
+    {
+        if (sfLaser(g, k)[3])
+        {
+            blit(o->screen, sfLaser(g, k)[0], env->laserArt, LASER_WIDTH);
+        }
+    }
+}
+
+void sfEnvReset(struct sfEnv *env, int n, struct sfObs *obs)
+{
+    env->n = (n < env->capacity) ? n : env->capacity;
+    for (int i = 0; i < env->n; i++)
+    {
+        sfResetScript(&env->games[i], waveScript, SFENV_DIFFICULTY, 2 * i + 1);
+        observe(env, &env->games[i], &obs[i]);
+    }
+}
+
+void sfEnvStepRange(struct sfEnv *env, int first, int count,
+                    const unsigned char *actions, struct sfObs *obs,
+                    float *reward, unsigned char *done)
+{
+    int last = (first + count < env->n) ? first + count : env->n;
+
+    for (int i = first; i < last; i++)
+    {
+        struct sfGame *g = &env->games[i];
+        int end, flags;
+
+        if (env->mode == SFENV_SINGLE)
+        {
+            //singleMode::tick() only moves on exactly one button
+            int action = (actions[i] == SF_P1_UP) ? SF_UP :
+                         (actions[i] == SF_P1_DOWN) ? SF_DOWN : SF_NONE;
+
+            end = sfStep(g, action);
+            reward[i] = end ? SFENV_SHOT : SFENV_ALIVE;
+        }
+        else
+        {
+            end = sfMultStep(g, actions[i]);
+            reward[i] = (end == 1) ? SFENV_WIN : (end == 2) ? -SFENV_WIN : 0.0f;
+        }
+
+        flags = end ? SFENV_HIT : 0;
+        if (!end && env->frameCap && (g->frames >= env->frameCap))
+        {
+            flags = SFENV_CAPPED;
+        }
+        done[i] = (unsigned char)flags;
+        if (flags)
+        {
+            //next seed from how this game went, games never share one
+            sfResetScript(g, waveScript, SFENV_DIFFICULTY, g->s.waveSeed + g->frames);
+        }
+        observe(env, g, &obs[i]);
+    }
+}
+
+void sfEnvStep(struct sfEnv *env, const unsigned char *actions, struct sfObs *obs,
+               float *reward, unsigned char *done)
+{
+    sfEnvStepRange(env, 0, env->n, actions, obs, reward, done);
+}
@@ -0,0 +1,75 @@
+/*
+===============================================================================
+ Name        : sfenv.h
+ Description : Vectorized environment over the game rules in sfcore.h, for
+ training and evaluating bot pilots offline. An environment holds N games
+ that reset and step in lock-step; every step writes each game's
+ observation, reward and done flag straight into arrays the caller owns,
+ so nothing is copied or allocated after sfEnvCreate(). Environments share
+ no state, so threads can each drive their own (or their own range of one
+ with sfEnvStepRange()).
+
+     cc -O2 -c tools/sfenv.c                          (link it in)
+     cc -O2 -shared -fPIC -o libsfenv.so tools/sfenv.c  (for ctypes/cffi)
+
+ actions are controller bytes, the same bits the game reads from the
+ expander (SF_P1_UP etc. in sfcore.h). single player only looks at
+ SF_P1_UP and SF_P1_DOWN and multiplayer applies multMode::tick()'s
+ button rules to the whole byte, so one byte drives both ships
+===============================================================================
+*/
+#ifndef SFENV_H
+#define SFENV_H
+
+#include "sfcore.h"
+
+#define SFENV_SINGLE 2          //same numbers as the mode buttons
+#define SFENV_MULTI 1
+
+//done flags
+#define SFENV_HIT 1             //the game ended (hit, or someone won)
+#define SFENV_CAPPED 2          //ran into the frame cap
+
+//rewards, single player is survival, multiplayer is from player 1's side
+#define SFENV_ALIVE 1.0f        //per frame survived
+#define SFENV_SHOT -1.0f        //the frame the player is hit
+#define SFENV_WIN 1.0f          //player 1 won (player 2 winning is -1)
+
+//one game's observation, 528 bytes with no padding. screen is the frame
+//drawn from the state after the step in the firmware's page format (84
+//columns x 6 pages, bit 0 at the top of each page), the rest is that
+//state as numbers
+struct sfObs
+{
+    unsigned char screen[SF_WIDTH * SF_PAGES];
+    short tie[2];               //tieFighter1/2 array positions
+    short laser[4];             //laser1, laser11, laser2, laser21
+    unsigned char on[4];        //which lasers are out
+    unsigned int frames;        //frames into the current game
+    int wave;                   //page the last single player wave was aimed at
+};
+
+struct sfEnv;
+
+//room for up to capacity games (mode SFENV_SINGLE or SFENV_MULTI, a
+//frameCap of 0 for none), 0 if it can't be allocated. render 0 leaves
+//the screens alone for the speed
+struct sfEnv *sfEnvCreate(int capacity, int mode, int frameCap, int render);
+void sfEnvDestroy(struct sfEnv *env);
+
+//starts n games (up to the capacity) and writes their observations
+void sfEnvReset(struct sfEnv *env, int n, struct sfObs *obs);
+
+//advances every game a frame with actions[n]. a game that finishes gets
+//its done flags and reward, then starts over, so its observation is the
+//first frame of the next game
+void sfEnvStep(struct sfEnv *env, const unsigned char *actions, struct sfObs *obs,
+               float *reward, unsigned char *done);
+
+//the same for games first to first + count - 1 only (all arrays still
+//indexed from game 0), for splitting a batch across threads
+void sfEnvStepRange(struct sfEnv *env, int first, int count,
+                    const unsigned char *actions, struct sfObs *obs,
+                    float *reward, unsigned char *done);
+
+#endif
@@ -0,0 +1,463 @@
+/*
+===============================================================================
+ Name        : sfvplay.c
+ Description : Player for Star Fight gameplay captures (CAPTURE_ENABLE
+ builds). Reads a host sim capture (SF_CAPTURE) or a ring pulled off the
+ board with a debugger, then plays it back in the terminal at the speed it
+ was recorded, exports it as an animated GIF, or just prints its size.
+
+     cc -O2 -o sfvplay tools/sfvplay.c
+     ./sfvplay capture.sfv                   (play it)
+     ./sfvplay -g capture.gif -x 4 capture.bin
+
+ -g file   write a GIF instead of playing     -x scale  GIF pixels per dot (3)
+ -s speed  playback speed (1.0)               -i        print the stats only
+
+ The coding is described with captureFrame() in StarFight.cpp: a file is
+ "SFV1", width, pages, two zero bytes and XOR delta records from a blank
+ screen; a ring image is the captureRing struct, whose base screen and
+ records from tail to head decode the same way.
+===============================================================================
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static int width, pages;
+static int frameCount;
+static unsigned char *screens;      //frameCount screens, width x pages each
+static int *frameMs;                //time since the previous frame
+static long recordBytes;            //coded size of all the records
+
+//**************************************************************************
+//decoding
+//
+
+static unsigned char *slurp(const char *path, long *size)
+{
+    FILE *f = fopen(path, "rb");
+    unsigned char *data;
+
+    if (!f)
+    {
+        perror(path);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc(*size ? *size : 1);
+    if (!data || (fread(data, 1, *size, f) != (size_t)*size))
+    {
+        fprintf(stderr, "%s: can't read it\n", path);
+        exit(1);
+    }
+    fclose(f);
+    return data;
+}
+
+//applies the record at rec (up to end) to screen, returns its length or
+//-1 if it runs off the end or past a page
+static long applyRecord(const unsigned char *rec, long end, unsigned char *screen)
+{
+    long at = 2;
+
+    if (end < 2)
+    {
+        return -1;
+    }
+    for (int p = 0; p < 8; p++)
+    {
+        if (!(rec[0] & (1 << p)))
+        {
+            continue;
+        }
+        if (p >= pages)
+        {
+            return -1;
+        }
+        for (int c = 0; c < width;)
+        {
+            int token;
+
+            if (at >= end)
+            {
+                return -1;
+            }
+            token = rec[at++];
+            if (token < 0x80)
+            {
+                c += token + 1;
+                continue;
+            }
+            if ((c + token - 0x7F > width) || (at + token - 0x7F > end))
+            {
+                return -1;
+            }
+            for (int k = 0x7F; k < token; k++)
+            {
+                screen[p * width + c++] ^= rec[at++];
+            }
+        }
+    }
+    return at;
+}
+
+//decodes records from a start screen into screens[]
+static void decode(const unsigned char *rec, long size, const unsigned char *start)
+{
+    int frameBytes = width * pages;
+    int room = 1024;
+    unsigned char *screen = malloc(frameBytes);
+
+    memcpy(screen, start, frameBytes);
+    screens = malloc((size_t)room * frameBytes);
+    frameMs = malloc(room * sizeof(int));
+    recordBytes = size;
+
+    for (long at = 0; at < size;)
+    {
+        long n = applyRecord(rec + at, size - at, screen);
+
+        if (n < 0)
+        {
+            fprintf(stderr, "corrupt record at byte %ld (frame %d), stopping there\n",
+                    at, frameCount);
+            recordBytes = at;
+            break;
+        }
+        if (frameCount == room)
+        {
+            room *= 2;
+            screens = realloc(screens, (size_t)room * frameBytes);
+            frameMs = realloc(frameMs, room * sizeof(int));
+        }
+        memcpy(screens + (size_t)frameCount * frameBytes, screen, frameBytes);
+        frameMs[frameCount++] = rec[at + 1];
+        at += n;
+    }
+    free(screen);
+}
+
+static unsigned int le32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static void load(const char *path)
+{
+    long size;
+    unsigned char *data = slurp(path, &size);
+
+    if ((size >= 8) && !memcmp(data, "SFV1", 4))
+    {
+        unsigned char *blank;
+
+        width = data[4];
+        pages = data[5];
+        blank = calloc(width * pages + 1, 1);
+        decode(data + 8, size - 8, blank);
+        free(blank);
+    }
+    else if ((size >= 20) && !memcmp(data, "SFVR", 4))
+    {
+        //struct captureRing, little endian with no padding
+        unsigned int ringSize = data[6] | (data[7] << 8);
+        unsigned int head = le32(data + 8);
+        unsigned int tail = le32(data + 12);
+        unsigned int used = head - tail;
+        const unsigned char *base = data + 20;
+        const unsigned char *ring;
+        unsigned char *linear;
+
+        width = data[4];
+        pages = data[5];
+        ring = base + width * pages;
+        if (!ringSize || (ringSize & (ringSize - 1)) || (used > ringSize) ||
+                (ring + ringSize > data + size))
+        {
+            fprintf(stderr, "%s: ring image is cut short or damaged\n", path);
+            exit(1);
+        }
+
+        linear = malloc(used + 1);
+        for (unsigned int i = 0; i < used; i++)
+        {
+            linear[i] = ring[(tail + i) & (ringSize - 1)];
+        }
+        decode(linear, used, base);
+        free(linear);
+    }
+    else
+    {
+        fprintf(stderr, "%s: not a Star Fight capture\n", path);
+        exit(1);
+    }
+
+    if (!width || !pages || (pages > 8))
+    {
+        fprintf(stderr, "%s: bad screen size %dx%d\n", path, width, pages * 8);
+        exit(1);
+    }
+    free(data);
+}
+
+static int dot(const unsigned char *screen, int x, int y)
+{
+    return (screen[(y / 8) * width + x] >> (y % 8)) & 1;
+}
+
+//**************************************************************************
+//terminal playback, two rows of dots per line with half blocks
+//
+
+static void play(double speed)
+{
+    static const char *cell[4] = {" ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88"};
+    struct timespec gap;
+
+    printf("\033[2J\033[?25l");
+    for (int f = 0; f < frameCount; f++)
+    {
+        const unsigned char *screen = screens + (size_t)f * width * pages;
+        long ns = (long)(frameMs[f] * 1e6 / speed);
+
+        gap.tv_sec = ns / 1000000000;
+        gap.tv_nsec = ns % 1000000000;
+        nanosleep(&gap, 0);
+
+        printf("\033[H");
+        for (int y = 0; y < pages * 8; y += 2)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                fputs(cell[dot(screen, x, y) | (dot(screen, x, y + 1) << 1)], stdout);
+            }
+            putchar('\n');
+        }
+        printf("frame %d/%d\n", f + 1, frameCount);
+        fflush(stdout);
+    }
+    printf("\033[?25h");
+}
+
+//**************************************************************************
+//GIF export, two colours (the 5110's backlight and its dots) and LZW
+//coded frames, one per capture frame that changed
+//
+
+struct bits
+{
+    FILE *f;
+    unsigned int acc;
+    int count;
+    unsigned char block[255];
+    int used;
+};
+
+static void blockFlush(struct bits *b)
+{
+    if (b->used)
+    {
+        fputc(b->used, b->f);
+        fwrite(b->block, 1, b->used, b->f);
+        b->used = 0;
+    }
+}
+
+static void putCode(struct bits *b, int code, int size)
+{
+    b->acc |= (unsigned int)code << b->count;
+    b->count += size;
+    while (b->count >= 8)
+    {
+        b->block[b->used++] = b->acc & 0xFF;
+        b->acc >>= 8;
+        b->count -= 8;
+        if (b->used == 255)
+        {
+            blockFlush(b);
+        }
+    }
+}
+
+//pixels are 0 or 1, minimum code size 2 (clear 4, end 5)
+static void lzw(FILE *f, const unsigned char *px, long n)
+{
+    static short next[4096][4];
+    struct bits b = {f, 0, 0, {0}, 0};
+    int size = 3;
+    int maxCode = 5;
+    int cur = px[0];
+
+    fputc(2, f);
+    memset(next, 0, sizeof(next));
+    putCode(&b, 4, size);
+
+    for (long i = 1; i < n; i++)
+    {
+        int c = px[i];
+
+        if (next[cur][c])
+        {
+            cur = next[cur][c];
+            continue;
+        }
+        putCode(&b, cur, size);
+        next[cur][c] = ++maxCode;
+        if (maxCode >= (1 << size))
+        {
+            size++;
+        }
+        if (maxCode == 4095)
+        {
+            putCode(&b, 4, size);
+            memset(next, 0, sizeof(next));
+            size = 3;
+            maxCode = 5;
+        }
+        cur = c;
+    }
+    putCode(&b, cur, size);
+    putCode(&b, 4, size);
+    putCode(&b, 5, 3);
+    if (b.count)
+    {
+        putCode(&b, 0, 8 - b.count);
+    }
+    blockFlush(&b);
+    fputc(0, f);
+}
+
+static void put16(FILE *f, int v)
+{
+    fputc(v & 0xFF, f);
+    fputc(v >> 8, f);
+}
+
+static void gif(const char *path, int scale)
+{
+    static const unsigned char palette[12] = {0xA8, 0xC6, 0x8C, 0x1E, 0x2A, 0x1E};
+    int w = width * scale;
+    int h = pages * 8 * scale;
+    int frameBytes = width * pages;
+    unsigned char *px = malloc((size_t)w * h);
+    FILE *f = fopen(path, "wb");
+
+    if (!f)
+    {
+        perror(path);
+        exit(1);
+    }
+
+    fwrite("GIF89a", 1, 6, f);
+    put16(f, w);
+    put16(f, h);
+    fputc(0x81, f);                 //global table of 4 colours
+    fputc(0, f);
+    fputc(0, f);
+    fwrite(palette, 1, sizeof(palette), f);
+    fwrite("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 1, 19, f);
+
+    for (int f0 = 0; f0 < frameCount;)
+    {
+        const unsigned char *screen = screens + (size_t)f0 * frameBytes;
+        int ms = 0;
+        int f1 = f0 + 1;
+
+        //frames that didn't change just lengthen the one before
+        while ((f1 < frameCount) &&
+                !memcmp(screens + (size_t)f1 * frameBytes, screen, frameBytes))
+        {
+            ms += frameMs[f1++];
+        }
+        ms += (f1 < frameCount) ? frameMs[f1] : 2000;
+
+        for (int y = 0; y < h; y++)
+        {
+            for (int x = 0; x < w; x++)
+            {
+                px[(size_t)y * w + x] = dot(screen, x / scale, y / scale);
+            }
+        }
+
+        fwrite("\x21\xF9\x04\x00", 1, 4, f);
+        put16(f, (ms + 5) / 10);
+        fputc(0, f);
+        fputc(0, f);
+        fputc(0x2C, f);
+        put16(f, 0);
+        put16(f, 0);
+        put16(f, w);
+        put16(f, h);
+        fputc(0, f);
+        lzw(f, px, (long)w * h);
+        f0 = f1;
+    }
+    fputc(0x3B, f);
+    fclose(f);
+    free(px);
+}
+
+//**************************************************************************
+
+int main(int argc, char **argv)
+{
+    const char *gifPath = 0;
+    double speed = 1.0;
+    int scale = 3;
+    int info = 0;
+    long totalMs = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:x:s:i")) != -1)
+    {
+        switch (opt)
+        {
+            case 'g': gifPath = optarg; break;
+            case 'x': scale = atoi(optarg); break;
+            case 's': speed = atof(optarg); break;
+            case 'i': info = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-i] [-g out.gif] [-x scale] [-s speed] capture\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if ((optind != argc - 1) || (scale < 1) || (scale > 16) || (speed <= 0))
+    {
+        fprintf(stderr, "usage: %s [-i] [-g out.gif] [-x scale] [-s speed] capture\n",
+                argv[0]);
+        return 1;
+    }
+
+    load(argv[optind]);
+    if (!frameCount)
+    {
+        fprintf(stderr, "%s: no frames\n", argv[optind]);
+        return 1;
+    }
+    for (int f = 0; f < frameCount; f++)
+    {
+        totalMs += frameMs[f];
+    }
+
+    if (info || !isatty(STDOUT_FILENO) || gifPath)
+    {
+        fprintf(gifPath ? stderr : stdout,
+                "%dx%d, %d frames over %.1fs, %ld bytes (%.1f a frame vs %d raw)\n",
+                width, pages * 8, frameCount, totalMs / 1000.0, recordBytes,
+                (double)recordBytes / frameCount, width * pages);
+    }
+    if (gifPath)
+    {
+        gif(gifPath, scale);
+    }
+    else if (!info && isatty(STDOUT_FILENO))
+    {
+        play(speed);
+    }
+    return 0;
+}
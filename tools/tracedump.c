@@ -0,0 +1,328 @@
+/*
+===============================================================================
+ Name        : tracedump.c
+ Description : Decoder for the binary event trace StarFight.cpp sends out of
+ UART0 when built with TRACE_ENABLE (or that the host simulator writes to
+ $SF_TRACE). Prints a readable timeline and can also write the events as
+ Chrome trace JSON for chrome://tracing or Perfetto.
+
+     cc -O2 -o tracedump tools/tracedump.c
+     ./tracedump [-j trace.json] [-w columns] [capture.bin]  (stdin without a file)
+
+ positions are split into page and column by the panel width the boot
+ records carry. -w gives it for captures that start after boot (84, the
+ 5110's, if neither says)
+===============================================================================
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//must match the event trace section of StarFight.cpp
+#define TRACE_SYNC 0xA5
+#define TRACE_RECORD 8
+
+#define TR_INPUT 1
+#define TR_FIRE 2
+#define TR_WAVE 3
+#define TR_HIT 4
+#define TR_GAMEOVER 5
+#define TR_FRAME 6
+#define TR_OVERRUN 7
+#define TR_BOOT 8
+#define TR_BUSFAULT 9
+#define TR_TASK 10
+#define TR_BENCH 11
+#define TR_BUS 12
+#define TR_LAST TR_BUS
+
+static const char *eventName[] = {
+    "?", "input", "fire", "wave", "hit", "gameover", "frame", "overrun", "boot",
+    "busfault", "task", "bench", "bus"
+};
+
+static int glcdWidth = 84;      //GLCD_WIDTH of the build that's tracing
+
+//the task table in playGame() order, then idle
+static const char *taskName[] = {"input", "game", "display", "sound", "idle"};
+
+struct event
+{
+    unsigned long long us;  //unwrapped timer 0 tick
+    int id;
+    int a;
+    int b;
+};
+
+static void describe(const struct event *e, char *out, size_t size)
+{
+    switch (e->id)
+    {
+        case TR_INPUT:
+            snprintf(out, size, "buttons 0x%02X (was 0x%02X)", e->a, e->b);
+            break;
+        case TR_FIRE:
+            snprintf(out, size, "laser %d from %d (page %d col %d)", e->a, e->b,
+                     e->b / glcdWidth, e->b % glcdWidth);
+            break;
+        case TR_WAVE:
+            {
+                int used = snprintf(out, size, "player on page %d, lanes", e->a);
+
+                for (int lane = 0; lane < 16; lane++)
+                {
+                    if ((e->b & (1 << lane)) && ((size_t)used < size))
+                    {
+                        used += snprintf(out + used, size - used, " %d", lane);
+                    }
+                }
+            }
+            break;
+        case TR_HIT:
+            snprintf(out, size, "player %d hit at %d", e->a, e->b);
+            break;
+        case TR_GAMEOVER:
+            if (e->a == 1)
+            {
+                snprintf(out, size, "single player, %d frames", e->b);
+            }
+            else if (e->a == 3)
+            {
+                snprintf(out, size, "endurance, %d frames", e->b);
+            }
+            else
+            {
+                snprintf(out, size, "multiplayer, player %d wins", e->b);
+            }
+            break;
+        case TR_FRAME:
+            snprintf(out, size, "#%d", e->b);
+            break;
+        case TR_OVERRUN:
+            snprintf(out, size, "frame took %.1f ms", e->b / 10.0);
+            break;
+        case TR_BOOT:
+            snprintf(out, size, "stage %d (%d columns)", e->a, e->b);
+            break;
+        case TR_BUSFAULT:
+            snprintf(out, size, "%s fault, %d so far", (e->a == 1) ? "I2C" : "SPI",
+                     e->b);
+            break;
+        case TR_TASK:
+            snprintf(out, size, "%s ran %d us this frame",
+                     (e->a < 5) ? taskName[e->a] : "?", e->b);
+            break;
+        case TR_BENCH:
+            if ((e->a >> 4) == 15)
+            {
+                snprintf(out, size, "hot paths in %s", e->b ? "RAM" : "flash");
+            }
+            else if ((e->a >> 4) == 2)
+            {
+                static const char *stress[3] = {"bullets sustained %d",
+                                                "bullets projected %d",
+                                                "worst frame at full pool %d cycles"};
+
+                snprintf(out, size, ((e->a & 15) < 3) ? stress[e->a & 15] : "stress ? %d",
+                         ((e->a & 15) == 2) ? e->b * 16 : e->b);
+            }
+            else
+            {
+                static const char *stat[3] = {"average", "min", "max"};
+
+                snprintf(out, size, "%s %s %d cycles", (e->a >> 4) ? "flush" : "update",
+                         ((e->a & 15) < 3) ? stat[e->a & 15] : "?", e->b * 16);
+            }
+            break;
+        case TR_BUS:
+            {
+                //the frames figure comes first in each second's set
+                static int frames = 0;
+                static const char *bus[10] = {"", "spi bytes", "spi idle bytes",
+                                              "spi transfers", "spi busy", "spi wait",
+                                              "i2c bytes", "i2c transfers", "i2c busy",
+                                              "i2c wait"};
+
+                if (e->a == 0)
+                {
+                    frames = e->b;
+                    snprintf(out, size, "%d frames in the last second", e->b);
+                }
+                else if ((e->a == 4) || (e->a == 5) || (e->a == 8) || (e->a == 9))
+                {
+                    snprintf(out, size, "%s %.1f%%%s", bus[e->a], e->b / 10.0,
+                             ((e->a == 5) || (e->a == 9)) ? " of the CPU" : "");
+                }
+                else if (e->a < 10)
+                {
+                    snprintf(out, size, "%s %d, %.1f a frame", bus[e->a], e->b,
+                             frames ? (double)e->b / frames : 0.0);
+                }
+                else
+                {
+                    snprintf(out, size, "figure %d = %d", e->a, e->b);
+                }
+            }
+            break;
+        default:
+            snprintf(out, size, "a=%d b=%d", e->a, e->b);
+    }
+}
+
+static void jsonEvent(FILE *json, int *first, const struct event *e,
+                      unsigned long long duration)
+{
+    char text[96];
+
+    describe(e, text, sizeof(text));
+    fprintf(json, "%s\n  {\"name\":\"%s\",\"cat\":\"starfight\",", *first ? "" : ",",
+            e->id == TR_FRAME ? "frame" : eventName[e->id]);
+    if (e->id == TR_TASK)
+    {
+        //a counter track per task
+        fprintf(json, "\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"args\":{\"%s\":%d}}",
+                e->us, (e->a < 5) ? taskName[e->a] : "?", e->b);
+        *first = 0;
+        return;
+    }
+    if (e->id == TR_FRAME)
+    {
+        fprintf(json, "\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":1,",
+                e->us, duration);
+    }
+    else
+    {
+        fprintf(json, "\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":2,", e->us);
+    }
+    fprintf(json, "\"args\":{\"a\":%d,\"b\":%d,\"what\":\"%s\"}}", e->a, e->b, text);
+    *first = 0;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin, *json = 0;
+    unsigned char win[TRACE_RECORD + 1], *buf;
+    int have = 0;
+    unsigned long long base = 0;
+    unsigned int lastTick = 0;
+    long long skipped = 0, count = 0;
+    struct event frame = {0, 0, 0, 0};
+    int haveFrame = 0, first = 1, opt, c;
+
+    while ((opt = getopt(argc, argv, "j:w:")) != -1)
+    {
+        if (opt == 'w')
+        {
+            glcdWidth = atoi(optarg);
+            if (glcdWidth < 1)
+            {
+                fprintf(stderr, "%s: bad width\n", argv[0]);
+                return 1;
+            }
+            continue;
+        }
+        if (opt != 'j')
+        {
+            fprintf(stderr, "usage: %s [-j trace.json] [-w columns] [capture]\n", argv[0]);
+            return 1;
+        }
+        json = fopen(optarg, "w");
+        if (!json)
+        {
+            perror(optarg);
+            return 1;
+        }
+    }
+    if ((optind < argc) && !(in = fopen(argv[optind], "rb")))
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (json)
+    {
+        fprintf(json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    }
+
+    //works through a sliding window so a live stream (stdin from the
+    //serial port) can be resynced without seeking
+    setvbuf(stdout, 0, _IOLBF, 0);
+    while (1)
+    {
+        struct event e;
+        char text[96];
+
+        while ((have < TRACE_RECORD + 1) && ((c = fgetc(in)) != EOF))
+        {
+            win[have++] = (unsigned char)c;
+        }
+        if (have < TRACE_RECORD + 1)
+        {
+            break;
+        }
+
+        buf = win + 1;
+        e.id = buf[4];
+        if ((win[0] != TRACE_SYNC) || (e.id < 1) || (e.id > TR_LAST))
+        {
+            //not a record start, look again one byte further on
+            skipped++;
+            memmove(win, win + 1, --have);
+            continue;
+        }
+        have = 0;
+
+        //timer 0 wraps every 71 minutes
+        {
+            unsigned int tick = buf[0] | (buf[1] << 8) | (buf[2] << 16) |
+                                ((unsigned int)buf[3] << 24);
+
+            if (count && (tick < lastTick))
+            {
+                base += 1ull << 32;
+            }
+            lastTick = tick;
+            e.us = base + tick;
+        }
+        e.a = buf[5];
+        e.b = buf[6] | (buf[7] << 8);
+        count++;
+        if ((e.id == TR_BOOT) && e.b)
+        {
+            glcdWidth = e.b;
+        }
+
+        describe(&e, text, sizeof(text));
+        printf("%12.3f ms  %-8s  %s\n", e.us / 1000.0, eventName[e.id], text);
+
+        if (json)
+        {
+            //a frame's length is only known once the next one starts
+            if (e.id == TR_FRAME)
+            {
+                if (haveFrame)
+                {
+                    jsonEvent(json, &first, &frame, e.us - frame.us);
+                }
+                frame = e;
+                haveFrame = 1;
+            }
+            else
+            {
+                jsonEvent(json, &first, &e, 0);
+            }
+        }
+    }
+
+    if (json)
+    {
+        if (haveFrame)
+        {
+            jsonEvent(json, &first, &frame, lastTick + base - frame.us);
+        }
+        fprintf(json, "\n]}\n");
+        fclose(json);
+    }
+    fprintf(stderr, "%lld records, %lld bytes skipped resyncing\n", count, skipped);
+    return 0;
+}
@@ -0,0 +1,405 @@
+/*
+===============================================================================
+ Name        : wavec.c
+ Description : Wave script assembler for Star Fight. Turns the single
+ player wave patterns in a text file (see assets/waves.txt for the
+ instructions) into the bytecode comeAtMeBro() runs, written as a C
+ include with each instruction's source line beside its bytes, and/or
+ as the raw bytes for tools/balance.c -w to try out.
+
+     cc -O2 -o tools/wavec tools/wavec.c
+     tools/wavec -c waves.inc assets/waves.txt
+     tools/wavec -o mine.bin mine.txt
+
+ Encoding, one opcode byte and then its operands:
+     0 end                   1 fire LANES            2 aimed LANES x 6
+     3 delay TICKS           4 speed MS              5 ramp MS FLOOR
+     6 repeat COUNT          7 loop                  8 random COUNT ADDR...
+     9 jump ADDR
+ LANES is a page mask (bit 0 the top page), ADDR a little endian offset
+ into the script. Names can be used before they're defined.
+===============================================================================
+*/
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_SCRIPT 0x10000
+#define MAX_LINES 4096
+#define MAX_NAMES 256
+#define MAX_FIXUPS 4096
+#define MAX_LASERS 4
+
+#define OP_END 0
+#define OP_FIRE 1
+#define OP_AIMED 2
+#define OP_DELAY 3
+#define OP_SPEED 4
+#define OP_RAMP 5
+#define OP_REPEAT 6
+#define OP_LOOP 7
+#define OP_RANDOM 8
+#define OP_JUMP 9
+
+//operand letters: l lanes (any page), a lanes for aimed (pages 0-5),
+//n 1-255, z 0-255, * one or more names, j one name
+struct opInfo
+{
+    const char *name;
+    int code;
+    const char *operands;
+};
+
+static const struct opInfo ops[] = {
+    {"end", OP_END, ""},
+    {"fire", OP_FIRE, "l"},
+    {"aimed", OP_AIMED, "aaaaaa"},
+    {"delay", OP_DELAY, "n"},
+    {"speed", OP_SPEED, "n"},
+    {"ramp", OP_RAMP, "zn"},
+    {"repeat", OP_REPEAT, "n"},
+    {"loop", OP_LOOP, ""},
+    {"random", OP_RANDOM, "*"},
+    {"jump", OP_JUMP, "j"},
+};
+
+struct name
+{
+    char text[64];
+    int addr;
+};
+
+//a name used before its address is known, patched in by resolve()
+struct fixup
+{
+    char text[64];
+    int at;
+    char where[600];
+};
+
+//what writeC() prints beside each instruction's bytes
+struct line
+{
+    int addr;
+    int size;
+    char source[128];
+};
+
+static unsigned char script[MAX_SCRIPT];
+static int scriptSize = 0;
+static struct name names[MAX_NAMES];
+static int nameCount = 0;
+static struct fixup fixups[MAX_FIXUPS];
+static int fixupCount = 0;
+static struct line lines[MAX_LINES];
+static int lineCount = 0;
+
+static void fail(const char *what, const char *why)
+{
+    fprintf(stderr, "wavec: %s: %s\n", what, why);
+    exit(1);
+}
+
+static void emit(const char *where, int byte)
+{
+    if (scriptSize == MAX_SCRIPT)
+    {
+        fail(where, "script too big");
+    }
+    script[scriptSize++] = byte;
+}
+
+//**************************************************************************
+//operands
+//
+
+//digits for pages, each at most once
+static int lanes(const char *where, const char *text, int pages)
+{
+    int mask = 0, count = 0;
+
+    for (const char *c = text; *c; c++)
+    {
+        if (!isdigit((unsigned char)*c) || (*c - '0' >= pages) || (mask & (1 << (*c - '0'))))
+        {
+            fail(where, (pages == 6) ? "aimed lanes are the digits 0-5, once each" :
+                        "lanes are the digits 0-7, once each");
+        }
+        mask |= 1 << (*c - '0');
+        count++;
+    }
+    if (count > MAX_LASERS)
+    {
+        fail(where, "only 4 lasers to fire");
+    }
+    return mask;
+}
+
+static int number(const char *where, const char *text, int min)
+{
+    char *end;
+    long n = strtol(text, &end, 10);
+
+    if (*end || (end == text) || (n < min) || (n > 255))
+    {
+        fail(where, min ? "expected a number 1-255" : "expected a number 0-255");
+    }
+    return (int)n;
+}
+
+static void address(const char *where, const char *text)
+{
+    struct fixup *f = &fixups[fixupCount];
+
+    if (fixupCount == MAX_FIXUPS)
+    {
+        fail(where, "too many jumps");
+    }
+    snprintf(f->text, sizeof(f->text), "%s", text);
+    snprintf(f->where, sizeof(f->where), "%s", where);
+    f->at = scriptSize;
+    fixupCount++;
+    emit(where, 0);
+    emit(where, 0);
+}
+
+static void define(const char *where, const char *text)
+{
+    if ((strlen(text) == 0) || (strlen(text) >= sizeof(names[0].text)))
+    {
+        fail(where, "bad name");
+    }
+    for (int i = 0; i < nameCount; i++)
+    {
+        if (!strcmp(names[i].text, text))
+        {
+            fail(where, "name defined twice");
+        }
+    }
+    if (nameCount == MAX_NAMES)
+    {
+        fail(where, "too many names");
+    }
+    snprintf(names[nameCount].text, sizeof(names[0].text), "%s", text);
+    names[nameCount].addr = scriptSize;
+    nameCount++;
+}
+
+static void resolve(void)
+{
+    for (int f = 0; f < fixupCount; f++)
+    {
+        int i;
+
+        for (i = 0; (i < nameCount) && strcmp(names[i].text, fixups[f].text); i++) {}
+        if (i == nameCount)
+        {
+            fail(fixups[f].where, "no such name");
+        }
+        script[fixups[f].at] = names[i].addr & 0xFF;
+        script[fixups[f].at + 1] = names[i].addr >> 8;
+    }
+}
+
+//**************************************************************************
+
+static void readScript(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char text[512], where[600];
+    int lineNo = 0, repeatOpen = 0;
+
+    if (!f)
+    {
+        fail(path, "can't open");
+    }
+
+    while (fgets(text, sizeof(text), f))
+    {
+        char *words[260], *hash = strchr(text, '#'), *colon;
+        const struct opInfo *op = 0;
+        int count = 0, start;
+
+        lineNo++;
+        snprintf(where, sizeof(where), "%s:%d", path, lineNo);
+        if (hash)
+        {
+            *hash = 0;
+        }
+        for (char *w = strtok(text, " \t\r\n"); w && (count < 260); w = strtok(0, " \t\r\n"))
+        {
+            words[count++] = w;
+        }
+
+        //a name, alone or ahead of an instruction
+        if (count && ((colon = strchr(words[0], ':')) != 0))
+        {
+            if (colon[1])
+            {
+                fail(where, "expected \"name:\"");
+            }
+            *colon = 0;
+            define(where, words[0]);
+            memmove(words, words + 1, --count * sizeof(words[0]));
+        }
+        if (!count)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+        {
+            if (!strcmp(words[0], ops[i].name))
+            {
+                op = &ops[i];
+            }
+        }
+        if (!op)
+        {
+            fail(where, "unknown instruction");
+        }
+        if (!strcmp(op->operands, "*") ? (count < 2) || (count > 256) :
+                (count != (int)strlen(op->operands) + 1))
+        {
+            fail(where, "wrong number of operands");
+        }
+
+        //REPEAT keeps one return address, so they can't nest
+        if (op->code == OP_REPEAT)
+        {
+            if (repeatOpen)
+            {
+                fail(where, "repeat inside a repeat");
+            }
+            repeatOpen = 1;
+        }
+        if (op->code == OP_LOOP)
+        {
+            if (!repeatOpen)
+            {
+                fail(where, "loop without a repeat");
+            }
+            repeatOpen = 0;
+        }
+
+        start = scriptSize;
+        emit(where, op->code);
+        if (op->code == OP_RANDOM)
+        {
+            emit(where, count - 1);
+        }
+        for (int k = 1; k < count; k++)
+        {
+            switch (op->operands[0] == '*' ? 'j' : op->operands[k - 1])
+            {
+                case 'l': emit(where, lanes(where, words[k], 8)); break;
+                case 'a': emit(where, lanes(where, words[k], 6)); break;
+                case 'n': emit(where, number(where, words[k], 1)); break;
+                case 'z': emit(where, number(where, words[k], 0)); break;
+                case 'j': address(where, words[k]); break;
+            }
+        }
+
+        if (lineCount == MAX_LINES)
+        {
+            fail(where, "too many instructions");
+        }
+        lines[lineCount].addr = start;
+        lines[lineCount].size = scriptSize - start;
+        snprintf(lines[lineCount].source, sizeof(lines[0].source), "%s", words[0]);
+        for (int k = 1; k < count; k++)
+        {
+            size_t used = strlen(lines[lineCount].source);
+
+            snprintf(lines[lineCount].source + used, sizeof(lines[0].source) - used,
+                     " %s", words[k]);
+        }
+        lineCount++;
+    }
+    fclose(f);
+
+    if (repeatOpen)
+    {
+        fail(path, "repeat without a loop");
+    }
+    if (!scriptSize)
+    {
+        fail(path, "no instructions");
+    }
+    resolve();
+}
+
+static void writeC(const char *path, const char *source)
+{
+    FILE *f = fopen(path, "w");
+
+    if (!f)
+    {
+        fail(path, "can't write");
+    }
+
+    fprintf(f, "//generated by tools/wavec.c from %s, edit that instead\n\n", source);
+    fprintf(f, "#ifndef WAVES_INC\n#define WAVES_INC\n\n");
+    fprintf(f, "static const unsigned char waveScript[%d] = {\n", scriptSize);
+    for (int i = 0; i < lineCount; i++)
+    {
+        char bytes[(2 + 2 * 255) * 6 + 1] = "";       //the longest random
+        int used = 0;
+
+        for (int b = 0; b < lines[i].size; b++)
+        {
+            used += snprintf(bytes + used, sizeof(bytes) - used, "0x%02X, ",
+                             script[lines[i].addr + b]);
+        }
+        fprintf(f, "    %-44s//%04X %s\n", bytes, lines[i].addr, lines[i].source);
+    }
+    fprintf(f, "};\n\n#endif\n");
+    fclose(f);
+}
+
+//the bare script, for tools/balance.c
+static void writeBin(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+
+    if (!f || (fwrite(script, 1, scriptSize, f) != (size_t)scriptSize) || fclose(f))
+    {
+        fail(path, "can't write");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *cPath = 0, *binPath = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c': cPath = optarg; break;
+            case 'o': binPath = optarg; break;
+            default: optind = argc + 1;
+        }
+    }
+    if ((optind != argc - 1) || (!cPath && !binPath))
+    {
+        fprintf(stderr, "usage: %s [-c waves.inc] [-o script.bin] waves.txt\n", argv[0]);
+        return 1;
+    }
+
+    readScript(argv[optind]);
+    if (cPath)
+    {
+        writeC(cPath, argv[optind]);
+    }
+    if (binPath)
+    {
+        writeBin(binPath);
+    }
+
+    fprintf(stderr, "%d instructions, %d bytes\n", lineCount, scriptSize);
+    return 0;
+}